@@ -0,0 +1,1679 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "engine.h"
+#include "samplestore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Layer
+
+	Layer::Layer() :
+		region(0),
+		group(-1),
+		off_by(-1),
+		seq(1),
+		sample(0),
+		streamed(false)
+	{
+		filter[0] = filter[1] = false;
+		eq_bands = 0;
+		eq_dynamic = false;
+		fileg = false;
+		pitcheg = false;
+		egs = 0;
+		amplfo = false;
+		fillfo = false;
+		pitchlfo = false;
+		lfos = 0;
+		delay = 0;
+		delay_random = 0;
+		delay_samples = 0;
+		stereo[0] = stereo[1] = StereoMixer::Place(2, 0, 100, 0);
+		stereo_dynamic = false;
+		pitch = 0;
+		pitch_keytrack = 0;
+		pitch_veltrack = 0;
+		pitch_random = 0;
+		bend_up = 0;
+		bend_down = 0;
+		bend_step = 0;
+		delay_beats = 0;
+		stop_beats = 0;
+		sync_beats = 0;
+		sync_offset = 0;
+	}
+
+	Layer::~Layer()
+	{
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class Voice
+
+	Voice::Voice() :
+		index(0),
+		layer(0),
+		chan(0),
+		key(0),
+		vel(0),
+		serial(0),
+		gain(0),
+		released(false),
+		sustained(false),
+		cached(false),
+		base_gain(0),
+		base_step(1),
+		rendered(0),
+		quiet(0),
+		fil_depth(0),
+		pitch_depth(0),
+		eg_pitch(0),
+		eg_gain(1),
+		lfo_pitch(0),
+		prev(0),
+		next(0)
+	{
+		cutoff[0] = cutoff[1] = 0;
+		eg_cutoff[0][0] = eg_cutoff[0][1] = 0;
+		eg_cutoff[1][0] = eg_cutoff[1][1] = 0;
+		eg_resonance[0] = eg_resonance[1] = 0;
+		for (int i = 0; i < LFOS; ++i)
+			std::fill(lfo_depth[i], lfo_depth[i] + LFO_TARGETS, 0.0f);
+	}
+
+	Voice::~Voice()
+	{
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class VoicePool
+
+	VoicePool::VoicePool(int capacity) :
+		_capacity(capacity),
+		_voices(capacity),
+		_free(capacity),
+		_free_count(capacity),
+		_head(0),
+		_tail(0)
+	{
+		// lowest slots are handed out first
+		for (int i = 0; i < capacity; ++i)
+		{
+			_voices[i].index = i;
+			_free[capacity - 1 - i] = &_voices[i];
+		}
+	}
+
+	VoicePool::~VoicePool()
+	{
+	}
+
+	Voice*
+	VoicePool::Allocate()
+	{
+		if (_free_count == 0)
+			return 0;
+
+		Voice* voice = _free[--_free_count];
+
+		voice->prev = _tail;
+		voice->next = 0;
+		if (_tail)
+			_tail->next = voice;
+		else
+			_head = voice;
+		_tail = voice;
+
+		return voice;
+	}
+
+	void
+	VoicePool::Release(Voice* voice)
+	{
+		if (voice->prev)
+			voice->prev->next = voice->next;
+		else
+			_head = voice->next;
+		if (voice->next)
+			voice->next->prev = voice->prev;
+		else
+			_tail = voice->prev;
+
+		voice->prev = voice->next = 0;
+		voice->layer = 0;
+		_free[_free_count++] = voice;
+	}
+
+	void
+	VoicePool::Clear()
+	{
+		while (_head)
+			Release(_head);
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class Engine
+
+	Engine::Engine(int polyphony) :
+		_pool(polyphony),
+		_steal_policy(STEAL_OLDEST),
+		_event_order(0),
+		_time(0),
+		_serial(0),
+		_cull_level(0),
+		_cull_frames(0),
+		_cull_window(0.05f),
+		_culled(0),
+		_saved_frames(0),
+		_random(1),
+		_sample_rate(44100),
+		_streamer(0),
+		_cache(0),
+		_instrument(0),
+		_sw_lokey(-1),
+		_sw_hikey(-1),
+		_last_sw_key(0),
+		_prev_key(0)
+	{
+		for (int c = 0; c < 16; ++c)
+		{
+			channel_t& channel = _channels[c];
+			channel.bend = 0;
+			channel.chanaft = 0;
+			channel.prog = 0;
+			channel.notes = 0;
+			channel.sustain = false;
+			std::memset(channel.polyaft, 0, sizeof(channel.polyaft));
+			std::memset(channel.note_vel, 0, sizeof(channel.note_vel));
+			std::memset(channel.note_on, 0, sizeof(channel.note_on));
+		}
+		std::memset(_sw, 0, sizeof(_sw));
+
+		int capacity = _pool.Capacity();
+		_buffer.assign(capacity * 2 * BLOCK_SIZE, 0.0f);
+		for (int f = 0; f < 2; ++f)
+		{
+			_filter[f].Resize(capacity);
+			_cutoff[f].Resize(capacity);
+			_resonance[f].Resize(capacity);
+		}
+		_eq.Resize(capacity);
+		_lfo.Resize(capacity * Voice::LFOS);
+		_envelope.assign(BLOCK_SIZE, 0.0f);
+		_lanes.assign(FilterBank::LANES * 2, (float*) 0);
+		_events.reserve(MAX_EVENTS);
+		_ghosts.reserve(polyphony * 4);
+		SetSampleRate(_sample_rate);
+	}
+
+	Engine::~Engine()
+	{
+	}
+
+	void
+	Engine::SetInstrument(Instrument* instrument)
+	{
+		kill_voices();
+		drop_voice_events();
+		pin_switch(_last_sw_key, false);
+		_instrument = instrument;
+		_layers.clear();
+		for (int k = 0; k < 128; ++k)
+		{
+			_by_key[k].clear();
+			_sw_samples[k].clear();
+		}
+		_sw_lokey = _sw_hikey = -1;
+
+		if (!instrument)
+			return;
+
+		// map group numbers to dense indices
+		std::map<int, int> groups;
+		for (size_t i = 0; i < instrument->regions.size(); ++i)
+		{
+			Region* region = instrument->regions[i];
+			if (region->group && groups.find(*region->group) == groups.end())
+			{
+				int index = groups.size();
+				groups[*region->group] = index;
+			}
+		}
+
+		_layers.resize(instrument->regions.size());
+		for (size_t i = 0; i < instrument->regions.size(); ++i)
+		{
+			Region* region = instrument->regions[i];
+			Layer& layer = _layers[i];
+
+			layer.region = region;
+			layer.seq = 1;
+			layer.group = region->group ? groups[*region->group] : -1;
+			layer.off_by = -1;
+			if (region->off_by)
+			{
+				std::map<int, int>::iterator it = groups.find(*region->off_by);
+				if (it != groups.end())
+					layer.off_by = it->second;
+			}
+			layer.filter[0] = region->cutoff;
+			layer.filter[1] = region->cutoff2;
+			if (layer.filter[0])
+				_filter_table.Prepare(region->fil_type);
+			if (layer.filter[1])
+				_filter_table.Prepare(region->fil2_type);
+			layer.xfade.Compile(region, _xfade_tables);
+			layer.matrix.Compile(region);
+
+			// bands at 0 dB without velocity or CC gain are skipped
+			const float gain[3] = { region->eq1_gain, region->eq2_gain, region->eq3_gain };
+			const float vel2gain[3] = { region->eq1_vel2gain, region->eq2_vel2gain, region->eq3_vel2gain };
+			layer.eq_bands = 0;
+			layer.eq_dynamic = false;
+			layer.fileg = region->fileg_depth != 0 || region->fileg_vel2depth != 0;
+			layer.pitcheg = region->pitcheg_depth != 0 || region->pitcheg_vel2depth != 0;
+			layer.egs = std::min<int>(region->eg.size(), Voice::MAX_EGS);
+			layer.amplfo = region->amplfo_depth != 0 || layer.matrix.HasTarget(MOD_AMPLFO_DEPTH) ||
+				region->amplfo_depthchanaft != 0 || region->amplfo_depthpolyaft != 0;
+			layer.fillfo = region->fillfo_depth != 0 || layer.matrix.HasTarget(MOD_FILLFO_DEPTH) ||
+				region->fillfo_depthchanaft != 0 || region->fillfo_depthpolyaft != 0;
+			layer.pitchlfo = region->pitchlfo_depth != 0 || layer.matrix.HasTarget(MOD_PITCHLFO_DEPTH) ||
+				region->pitchlfo_depthchanaft != 0 || region->pitchlfo_depthpolyaft != 0;
+			layer.lfos = std::min<int>(region->lfo.size(), Voice::MAX_LFOS);
+
+			for (int c = 0; c < 2; ++c)
+				layer.stereo[c] = StereoMixer::Place(c + 1, region->pan, region->width, region->position);
+			layer.stereo_dynamic = layer.matrix.HasTarget(MOD_PAN) || layer.matrix.HasTarget(MOD_WIDTH) ||
+				layer.matrix.HasTarget(MOD_POSITION);
+
+			const int cent = PitchTable::STEPS_PER_CENT;
+			layer.pitch = (region->transpose * 100 + region->tune -
+				       region->pitch_keycenter * region->pitch_keytrack) * cent;
+			layer.pitch_keytrack = region->pitch_keytrack * cent;
+			layer.pitch_veltrack = region->pitch_veltrack * cent;
+			layer.pitch_random = region->pitch_random * cent;
+			layer.bend_up = region->bend_up * cent;
+			layer.bend_down = region->bend_down * cent;
+			layer.bend_step = std::max(region->bend_step, 1) * cent;
+
+			layer.delay = region->delay ? *region->delay : 0;
+			layer.delay_random = region->delay_random ? *region->delay_random : 0;
+			layer.delay_samples = region->delay_samples ? *region->delay_samples : 0;
+			layer.delay_cc.clear();
+			for (int cc = 0; cc < 128; ++cc)
+			{
+				if (!region->delay_oncc[cc] && !region->delay_samples_oncc[cc])
+					continue;
+				Layer::delay_cc_t delay;
+				delay.cc = cc;
+				delay.seconds = region->delay_oncc[cc] ? *region->delay_oncc[cc] : 0;
+				delay.samples = region->delay_samples_oncc[cc] ? *region->delay_samples_oncc[cc] : 0;
+				layer.delay_cc.push_back(delay);
+			}
+			layer.delay_beats = region->delay_beats ? std::max(*region->delay_beats, 0) : 0;
+			layer.stop_beats = region->stop_beats ? std::max(*region->stop_beats, 0) : 0;
+			layer.sync_beats = region->sync_beats ? std::max(*region->sync_beats, 0) : 0;
+			layer.sync_offset = region->sync_offset ? std::max(*region->sync_offset, 0) : 0;
+			for (int b = 0; b < 3; ++b)
+			{
+				bool cc = layer.matrix.HasTarget(mod_target_t(MOD_EQ1_GAIN + b));
+				if (gain[b] == 0 && vel2gain[b] == 0 && !cc)
+					continue;
+				layer.eq_band[layer.eq_bands++] = b;
+				layer.eq_dynamic = layer.eq_dynamic || cc ||
+					layer.matrix.HasTarget(mod_target_t(MOD_EQ1_FREQ + b)) ||
+					layer.matrix.HasTarget(mod_target_t(MOD_EQ1_BW + b));
+			}
+
+			bind_sample(layer);
+
+			for (int k = region->lokey; k <= region->hikey; ++k)
+				if (k >= 0 && k < 128)
+					_by_key[k].push_back(i);
+
+			if (region->sw_lokey >= 0 && (_sw_lokey < 0 || region->sw_lokey < _sw_lokey))
+				_sw_lokey = region->sw_lokey;
+			if (region->sw_hikey > _sw_hikey)
+				_sw_hikey = region->sw_hikey;
+		}
+
+		for (size_t i = 0; i < _layers.size(); ++i)
+		{
+			Region* region = _layers[i].region;
+			if (region->sw_last >= 0 && region->sw_last < 128 && region->sample >= 0)
+				_sw_samples[region->sw_last].push_back(region->sample);
+		}
+		pin_switch(_last_sw_key, true);
+
+		_group_limit.assign(groups.size(), 0);
+		_group_count.assign(groups.size(), 0);
+		for (std::map<int, int>::iterator it = _group_limit_config.begin(); it != _group_limit_config.end(); ++it)
+		{
+			std::map<int, int>::iterator group = groups.find(it->first);
+			if (group != groups.end())
+				_group_limit[group->second] = it->second;
+		}
+	}
+
+	void
+	Engine::SetCulling(float threshold, float window)
+	{
+		_cull_level = std::pow(10.0f, threshold / 20.0f);
+		_cull_window = std::max(window, 0.0f);
+		_cull_frames = int(_cull_window * _sample_rate);
+	}
+
+	void
+	Engine::SetGroupPolyphony(int group, int voices)
+	{
+		_group_limit_config[group] = voices;
+
+		// update the compiled limit if the group is in use
+		for (size_t i = 0; i < _layers.size(); ++i)
+		{
+			if (_layers[i].group >= 0 && *_layers[i].region->group == group)
+			{
+				_group_limit[_layers[i].group] = voices;
+				break;
+			}
+		}
+	}
+
+	void
+	Engine::SetSampleRate(float rate)
+	{
+		_sample_rate = rate;
+		_cull_frames = int(_cull_window * rate);
+		_transport.SetSampleRate(rate);
+		_filter_table.SetSampleRate(rate);
+		_eq.SetSampleRate(rate);
+		for (int f = 0; f < 2; ++f)
+		{
+			_filter[f].SetSampleRate(rate);
+			_cutoff[f].SetRate(rate, BLOCK_SIZE);
+			_resonance[f].SetRate(rate, BLOCK_SIZE);
+		}
+		_lfo.SetRate(rate, BLOCK_SIZE);
+	}
+
+	void
+	Engine::SetSample(const std::string& path, const Sample* sample)
+	{
+		kill_voices();
+		int id = SampleStore::Instance().Intern(path);
+		_samples[id] = sample;
+		for (size_t i = 0; i < _layers.size(); ++i)
+			if (_layers[i].region->sample == id)
+				bind_sample(_layers[i]);
+	}
+
+	void
+	Engine::SetStreamer(DiskStreamer* streamer)
+	{
+		kill_voices();
+		_streamer = streamer;
+		for (size_t i = 0; i < _layers.size(); ++i)
+			bind_sample(_layers[i]);
+	}
+
+	void
+	Engine::SetCache(SampleCache* cache)
+	{
+		kill_voices();
+		pin_switch(_last_sw_key, false);
+		_cache = cache;
+		pin_switch(_last_sw_key, true);
+	}
+
+	void
+	Engine::bind_sample(Layer& layer)
+	{
+		// audio set by the host wins over the heads of the streamer
+		std::map<int, const Sample*>::iterator sample = _samples.find(layer.region->sample);
+		layer.sample = (sample != _samples.end()) ? sample->second : 0;
+		layer.streamed = false;
+		if (!layer.sample && _streamer)
+		{
+			layer.sample = _streamer->GetSample(layer.region->sample);
+			layer.streamed = layer.sample != 0;
+		}
+
+		if (layer.sample)
+			layer.seam.Bake(layer.sample, layer.region);
+		else
+			layer.seam.Clear();
+	}
+
+	void
+	Engine::Render(float* left, float* right, int frames)
+	{
+		std::memset(left, 0, frames * sizeof(float));
+		std::memset(right, 0, frames * sizeof(float));
+
+		while (frames > 0)
+		{
+			// events due now, then a block up to the next one
+			while (!_events.empty() && _events.front().time <= _time)
+			{
+				event_t event = _events.front();
+				std::pop_heap(_events.begin(), _events.end());
+				_events.pop_back();
+				dispatch(event);
+			}
+
+			int n = (frames < BLOCK_SIZE) ? frames : BLOCK_SIZE;
+			if (!_events.empty() && _events.front().time < _time + n)
+				n = int(_events.front().time - _time);
+			render_block(left, right, n);
+			left += n;
+			right += n;
+			frames -= n;
+			_time += n;
+			_transport.Advance(n);
+		}
+	}
+
+	void
+	Engine::SetTempo(float bpm, int frame)
+	{
+		if (frame > 0)
+		{
+			event_t event(EVENT_TEMPO);
+			event.tempo = bpm;
+			event.time = _time + frame;
+			if (push(event))
+				return;
+		}
+
+		_transport.SetTempo(bpm);
+		retime();
+	}
+
+	void
+	Engine::SetTransport(const Transport& transport)
+	{
+		_transport.SetTempo(transport.Tempo());
+		_transport.SetPosition(transport.Position());
+		_transport.SetTimeSignature(transport.Numerator(), transport.Denominator(), transport.Bar());
+		retime();
+	}
+
+	void
+	Engine::NoteOn(uint8_t chan, uint8_t key, uint8_t vel, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_NOTE_ON, chan, key, vel, 0, frame))
+			return;
+
+		// the per-key tables hold 128 entries, keep stray data bytes in them
+		key &= 127;
+		vel &= 127;
+
+		if (vel == 0)
+		{
+			NoteOff(chan, key, vel);
+			return;
+		}
+
+		channel_t& channel = _channels[(chan - 1) & 15];
+
+		_sw[key] = true;
+		if (key >= _sw_lokey && key <= _sw_hikey && key != _last_sw_key)
+		{
+			pin_switch(_last_sw_key, false);
+			_last_sw_key = key;
+			pin_switch(_last_sw_key, true);
+		}
+
+		trigger_t trig = TRIGGER_ATTACK | (channel.notes ? TRIGGER_LEGATO : TRIGGER_FIRST);
+
+		channel.note_on[key] = true;
+		channel.note_vel[key] = vel;
+		++channel.notes;
+
+		trigger(channel, chan, key, vel, trig);
+
+		_prev_key = key;
+	}
+
+	void
+	Engine::NoteOff(uint8_t chan, uint8_t key, uint8_t vel, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_NOTE_OFF, chan, key, vel, 0, frame))
+			return;
+
+		key &= 127;
+		vel &= 127;
+
+		channel_t& channel = _channels[(chan - 1) & 15];
+
+		_sw[key] = false;
+		if (!channel.note_on[key])
+			return;
+		channel.note_on[key] = false;
+		--channel.notes;
+
+		for (Voice* voice = _pool.First(); voice; )
+		{
+			Voice* next = voice->next;
+			if (voice->chan == chan && voice->key == key && !voice->released &&
+			    voice->layer->region->trigger != TRIGGER_RELEASE)
+			{
+				if (channel.sustain)
+					voice->sustained = true;
+				else
+					release_voice(voice);
+			}
+			voice = next;
+		}
+
+		if (!_ghosts.empty())
+			release_ghosts(chan, key);
+
+		// release triggered regions play with the note-on velocity
+		trigger(channel, chan, key, channel.note_vel[key], TRIGGER_RELEASE);
+	}
+
+	void
+	Engine::ControlChange(uint8_t chan, uint8_t cont, uint8_t val, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_CONTROL, chan, cont, val, 0, frame))
+			return;
+
+		cont &= 127;
+		val &= 127;
+
+		channel_t& channel = _channels[(chan - 1) & 15];
+		channel.control.Set(cont, val);
+
+		// sustain pedal
+		if (cont == 64)
+		{
+			bool down = val >= 64;
+			if (channel.sustain && !down)
+			{
+				for (Voice* voice = _pool.First(); voice; )
+				{
+					Voice* next = voice->next;
+					if (voice->chan == chan && voice->sustained)
+						release_voice(voice);
+					voice = next;
+				}
+				release_ghosts(chan, -1);
+			}
+			channel.sustain = down;
+		}
+
+		// regions triggered by controllers, the random draw is only taken
+		// once a region listens to this controller so that plain CC
+		// traffic leaves the sequence of the seeded generator alone
+		draws_t draws;
+		bool drawn = false;
+		uint8_t bpm = (uint8_t) std::min(_transport.Tempo(), 255.0);
+		for (size_t i = 0; i < _layers.size(); ++i)
+		{
+			Layer& layer = _layers[i];
+			Region* region = layer.region;
+			if (region->on_locc[cont] < 0 && region->start_locc[cont] < 0)
+				continue;
+			if (!drawn)
+			{
+				_random.Draw(draws);
+				drawn = true;
+			}
+			if (region->OnControl(chan, cont, val, channel.bend, bpm,
+					      channel.chanaft, 0, channel.prog, draws.value[DRAW_RAND], TRIGGER_ATTACK,
+					      channel.control.cc, 0, layer.seq, _sw, _last_sw_key, _prev_key))
+				launch(&layer, channel, chan, region->pitch_keycenter, 127, 0, draws);
+		}
+	}
+
+	void
+	Engine::PitchBend(uint8_t chan, int bend, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_BEND, chan, 0, 0, bend, frame))
+			return;
+
+		_channels[(chan - 1) & 15].bend = bend;
+	}
+
+	void
+	Engine::ChannelAftertouch(uint8_t chan, uint8_t val, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_CHANAFT, chan, 0, val, 0, frame))
+			return;
+
+		_channels[(chan - 1) & 15].chanaft = val;
+	}
+
+	void
+	Engine::PolyAftertouch(uint8_t chan, uint8_t key, uint8_t val, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_POLYAFT, chan, key, val, 0, frame))
+			return;
+
+		_channels[(chan - 1) & 15].polyaft[key & 127] = val;
+	}
+
+	void
+	Engine::ProgramChange(uint8_t chan, uint8_t prog, int frame)
+	{
+		if (frame > 0 && schedule(EVENT_PROGRAM, chan, 0, prog, 0, frame))
+			return;
+
+		_channels[(chan - 1) & 15].prog = prog;
+	}
+
+	void
+	Engine::AllSoundOff()
+	{
+		kill_voices();
+		drop_voice_events();
+		for (size_t g = 0; g < _group_count.size(); ++g)
+			_group_count[g] = 0;
+	}
+
+	bool
+	Engine::schedule(event_type_t type, uint8_t chan, uint8_t key, uint8_t value, int data,
+			 long frame, trigger_t trig)
+	{
+		event_t event(type, chan, key, value, data, trig);
+		event.time = _time + frame;
+		return push(event);
+	}
+
+	bool
+	Engine::push(event_t& event)
+	{
+		// a full queue handles the event right away rather than allocate
+		if (_events.size() >= MAX_EVENTS)
+			return false;
+
+		event.order = _event_order++;
+		_events.push_back(event);
+		std::push_heap(_events.begin(), _events.end());
+		return true;
+	}
+
+	bool
+	Engine::at_position(event_t& event, double position, long offset)
+	{
+		// nothing to wait for, the caller handles the event now
+		long frames = _transport.FramesUntil(position) + offset;
+		if (frames <= 0)
+			return false;
+
+		event.position = position;
+		event.offset = offset;
+		event.time = _time + frames;
+		return push(event);
+	}
+
+	void
+	Engine::retime()
+	{
+		bool moved = false;
+		for (size_t i = 0; i < _events.size(); ++i)
+		{
+			event_t& event = _events[i];
+			if (event.position < 0)
+				continue;
+			event.time = _time + _transport.FramesUntil(event.position) + event.offset;
+			moved = true;
+		}
+		if (moved)
+			std::make_heap(_events.begin(), _events.end());
+	}
+
+	void
+	Engine::dispatch(const event_t& event)
+	{
+		switch (event.type)
+		{
+		case EVENT_NOTE_ON:
+			NoteOn(event.chan, event.key, event.value);
+			break;
+		case EVENT_NOTE_OFF:
+			NoteOff(event.chan, event.key, event.value);
+			break;
+		case EVENT_CONTROL:
+			ControlChange(event.chan, event.key, event.value);
+			break;
+		case EVENT_BEND:
+			PitchBend(event.chan, event.data);
+			break;
+		case EVENT_CHANAFT:
+			ChannelAftertouch(event.chan, event.value);
+			break;
+		case EVENT_POLYAFT:
+			PolyAftertouch(event.chan, event.key, event.value);
+			break;
+		case EVENT_PROGRAM:
+			ProgramChange(event.chan, event.value);
+			break;
+		case EVENT_TEMPO:
+			SetTempo(float(event.tempo));
+			break;
+		case EVENT_START:
+		{
+			if (event.data < 0 || event.data >= (int) _layers.size())
+				break;
+			draws_t draws;
+			Random::Fill(draws, boost::uint32_t(event.serial));
+			Voice* voice = start_voice(&_layers[event.data], event.chan, event.key, event.value, draws);
+
+			// the note may have ended while the voice was waiting
+			channel_t& channel = _channels[(event.chan - 1) & 15];
+			if (voice && (event.trig & TRIGGER_ATTACK) && !channel.note_on[event.key])
+			{
+				if (channel.sustain)
+					voice->sustained = true;
+				else
+					release_voice(voice);
+			}
+			break;
+		}
+		case EVENT_STOP:
+		{
+			// stop_beats ends the voice even if its note is still held
+			Voice* voice = _pool.Get(event.data);
+			if (voice->layer && voice->serial == event.serial && !voice->released)
+				release_voice(voice);
+			break;
+		}
+		}
+	}
+
+	void
+	Engine::drop_voice_events()
+	{
+		size_t kept = 0;
+		for (size_t i = 0; i < _events.size(); ++i)
+		{
+			if (_events[i].type != EVENT_START && _events[i].type != EVENT_STOP)
+				_events[kept++] = _events[i];
+		}
+		_events.resize(kept);
+		std::make_heap(_events.begin(), _events.end());
+	}
+
+	long
+	Engine::start_delay(const Layer* layer, const channel_t& channel, const draws_t& draws)
+	{
+		float seconds = layer->delay + draws.value[DRAW_DELAY] * layer->delay_random;
+		long samples = layer->delay_samples;
+		for (size_t i = 0; i < layer->delay_cc.size(); ++i)
+		{
+			const Layer::delay_cc_t& delay = layer->delay_cc[i];
+			float cc = channel.control.cc[delay.cc] / 127.0f;
+			seconds += delay.seconds * cc;
+			samples += long(delay.samples * cc + 0.5f);
+		}
+		return long(seconds * _sample_rate + 0.5f) + samples;
+	}
+
+	void
+	Engine::launch(Layer* layer, channel_t& channel, uint8_t chan, uint8_t key, uint8_t vel, trigger_t trig,
+		       const draws_t& draws)
+	{
+		long delay = start_delay(layer, channel, draws);
+
+		// a waiting voice keeps the seed of the draws of its note
+		event_t event(EVENT_START, chan, key, vel, int(layer - &_layers[0]), trig);
+		event.serial = draws.seed;
+
+		// tempo synced starts wait for a position, delay is added after it
+		if (layer->delay_beats > 0 || layer->sync_beats > 0)
+		{
+			double position = _transport.After(_transport.Position(), layer->delay_beats);
+			if (layer->sync_beats > 0)
+				position = _transport.NextGrid(position, layer->sync_beats, layer->sync_offset);
+			if (at_position(event, position, delay))
+				return;
+		}
+		else if (delay > 0)
+		{
+			event.time = _time + delay;
+			if (push(event))
+				return;
+		}
+		start_voice(layer, chan, key, vel, draws);
+	}
+
+	void
+	Engine::trigger(channel_t& channel, uint8_t chan, uint8_t key, uint8_t vel, trigger_t trig)
+	{
+		const std::vector<int>& candidates = _by_key[key & 127];
+		draws_t draws;
+		_random.Draw(draws);
+		uint8_t bpm = (uint8_t) std::min(_transport.Tempo(), 255.0);
+
+		for (std::vector<int>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+		{
+			Layer& layer = _layers[*it];
+			Region* region = layer.region;
+			if (!(region->trigger & trig) || vel < region->lovel || vel > region->hivel)
+				continue;
+
+			int seq = layer.seq;
+			if (region->seq_length > 1)
+				layer.seq = seq % region->seq_length + 1;
+
+			if (region->OnKey(chan, key, vel, channel.bend, bpm,
+					  channel.chanaft, channel.polyaft[key], channel.prog,
+					  draws.value[DRAW_RAND], trig, channel.control.cc, 0, seq,
+					  _sw, _last_sw_key, _prev_key))
+				launch(&layer, channel, chan, key, vel, trig, draws);
+		}
+	}
+
+	Voice*
+	Engine::start_voice(Layer* layer, uint8_t chan, uint8_t key, uint8_t vel, const draws_t& draws)
+	{
+		Region* region = layer->region;
+		if (!layer->sample)
+			return 0;
+
+		// exclusive groups
+		if (layer->group >= 0)
+		{
+			for (Voice* voice = _pool.First(); voice; )
+			{
+				Voice* next = voice->next;
+				if (voice->layer->off_by == layer->group)
+				{
+					if (voice->layer->region->off_mode == OFF_FAST)
+						kill_voice(voice);
+					else
+						release_voice(voice);
+				}
+				voice = next;
+			}
+		}
+
+		// group polyphony
+		if (layer->group >= 0 && _group_limit[layer->group] > 0 &&
+		    _group_count[layer->group] >= _group_limit[layer->group])
+		{
+			Voice* victim = steal(layer->group, chan, key);
+			if (victim)
+				kill_voice(victim);
+		}
+
+		Voice* voice = _pool.Allocate();
+		if (!voice)
+		{
+			Voice* victim = steal(-1, chan, key);
+			if (!victim)
+				return 0;
+			kill_voice(victim);
+			voice = _pool.Allocate();
+		}
+
+		voice->layer = layer;
+		voice->chan = chan;
+		voice->key = key;
+		voice->vel = vel;
+		voice->serial = _serial++;
+		voice->gain = 1.0f;
+		voice->released = false;
+		voice->sustained = false;
+		voice->quiet = 0;
+
+		// amplifier
+		float velocity = vel / 127.0f;
+		float veltrack = region->amp_veltrack / 100.0f;
+		float db = region->volume + region->amp_keytrack * (key - region->amp_keycenter) +
+			region->amp_random * draws.value[DRAW_AMP];
+		voice->base_gain = std::pow(10.0f, db / 20.0f) *
+			(1.0f - veltrack + veltrack * velocity * velocity) *
+			layer->xfade.GetNoteGain(key, vel);
+
+		// pitch, pitch_random is centered on the note
+		int pitch = layer->pitch + key * layer->pitch_keytrack + layer->pitch_veltrack * vel / 127;
+		pitch += int(layer->pitch_random * (2.0f * draws.value[DRAW_PITCH] - 1.0f));
+		voice->base_step = _pitch_table.Ratio(pitch) * layer->sample->Rate() / _sample_rate;
+
+		std::fill(voice->mod, voice->mod + MOD_TARGET_COUNT, 0.0f);
+		layer->matrix.Evaluate(_channels[(chan - 1) & 15].control.cc, voice->mod);
+
+		// filters, modulation glides from the value at note-on
+		for (int f = 0; f < 2; ++f)
+		{
+			if (!layer->filter[f])
+				continue;
+
+			mod_target_t cutoff = f ? MOD_CUTOFF2 : MOD_CUTOFF;
+			mod_target_t resonance = f ? MOD_RESONANCE2 : MOD_RESONANCE;
+			int keytrack = f ? region->fil2_keytrack : region->fil_keytrack;
+			int keycenter = f ? region->fil2_keycenter : region->fil_keycenter;
+			int veltrack = f ? region->fil2_veltrack : region->fil_veltrack;
+
+			int random = f ? region->fil2_random : region->fil_random;
+			float track = keytrack * (key - keycenter) + veltrack * velocity +
+				random * (2.0f * draws.value[f ? DRAW_CUTOFF2 : DRAW_CUTOFF] - 1.0f);
+			float hz = f ? *region->cutoff2 : *region->cutoff;
+			if (hz < 1.0f)
+				hz = 1.0f;
+			voice->cutoff[f] = 1200.0f * std::log(hz / FilterTable::BASE_FREQUENCY) / std::log(2.0f) + track;
+
+			_filter[f].Reset(voice->index, f ? region->fil2_type : region->fil_type);
+			_cutoff[f].Reset(voice->index, voice->mod[cutoff], layer->matrix.GetSmooth(cutoff));
+			_resonance[f].Reset(voice->index, voice->mod[resonance], layer->matrix.GetSmooth(resonance));
+		}
+
+		if (layer->eq_bands)
+		{
+			_eq.Reset(voice->index, PKF_2P);
+			update_eq(voice);
+		}
+
+		start_envelopes(voice);
+		start_lfos(voice);
+
+		// a body held by the cache plays from memory, otherwise the
+		// frames after the head are streamed
+		long offset = region->offset ? *region->offset : 0;
+		if (region->offset_random)
+			offset += long(*region->offset_random * draws.value[DRAW_OFFSET]);
+		const Sample* sample = layer->sample;
+		Stream* stream = 0;
+		voice->cached = false;
+		if (layer->streamed && sample->Preloaded() < sample->Frames())
+		{
+			const Sample* body = _cache ? _cache->Play(region->sample) : 0;
+			if (body)
+			{
+				sample = body;
+				voice->cached = true;
+			}
+			else if (voice->index < _streamer->Streams())
+				stream = _streamer->Open(voice->index, region->sample, sample->Preloaded());
+		}
+		voice->playback.Start(sample, region, offset + long(voice->mod[MOD_SAMPLE_OFFSET]), stream, &layer->seam);
+		voice->gain = 0;
+
+		if (layer->group >= 0)
+			++_group_count[layer->group];
+
+		if (layer->stop_beats > 0)
+		{
+			event_t event(EVENT_STOP, chan, key, 0, voice->index);
+			event.serial = voice->serial;
+			at_position(event, _transport.After(_transport.Position(), layer->stop_beats), 0);
+		}
+
+		return voice;
+	}
+
+	int
+	Engine::bend_steps(const Layer* layer, int bend)
+	{
+		// bend_step quantizes to the nearest step, whole cents by default
+		long steps = (bend < 0) ? -long(bend) * layer->bend_down / 8192 : long(bend) * layer->bend_up / 8192;
+		long half = (steps < 0) ? -layer->bend_step / 2 : layer->bend_step / 2;
+		return int((steps + half) / layer->bend_step * layer->bend_step);
+	}
+
+	Voice*
+	Engine::steal(int group, uint8_t chan, uint8_t key)
+	{
+		// released voices are always taken before held ones, within
+		// each class the policy decides; the active list is in note-on
+		// order so the first match of equal rank is also the oldest
+		Voice* best = 0;
+		int best_rank = 0;
+		float best_gain = 0;
+
+		for (Voice* voice = _pool.First(); voice; voice = voice->next)
+		{
+			if (group >= 0 && voice->layer->group != group)
+				continue;
+
+			int rank = voice->released ? 0 : 2;
+			if (_steal_policy == STEAL_SAME_NOTE && !(voice->chan == chan && voice->key == key))
+				rank += 1;
+
+			float gain = voice->gain * voice->amp_eg.Value();
+			if (!best || rank < best_rank ||
+			    (rank == best_rank && _steal_policy == STEAL_QUIETEST && gain < best_gain))
+			{
+				best = voice;
+				best_rank = rank;
+				best_gain = gain;
+			}
+		}
+
+		return best;
+	}
+
+	void
+	Engine::render_block(float* left, float* right, int frames)
+	{
+		// LFOs of every voice advance together, at the rates set by the
+		// previous block
+		bool lfo = false;
+		for (Voice* voice = _pool.First(); voice && !lfo; voice = voice->next)
+			lfo = has_lfo(voice->layer);
+		if (lfo)
+			_lfo.Process(_pool.Capacity() * Voice::LFOS, float(frames) / BLOCK_SIZE);
+
+		// sources first, then all filters pack by pack, then mixdown
+		for (Voice* voice = _pool.First(); voice; voice = voice->next)
+			render_voice(voice, frames);
+
+		filter_block(frames);
+
+		for (Voice* voice = _pool.First(); voice; )
+		{
+			Voice* next = voice->next;
+			if (!mix_voice(voice, left, right, frames))
+				kill_voice(voice);
+			voice = next;
+		}
+
+		if (!_ghosts.empty())
+			update_ghosts(frames);
+
+		for (int c = 0; c < 16; ++c)
+			_channels[c].control.EndBlock();
+	}
+
+	void
+	Engine::render_voice(Voice* voice, int frames)
+	{
+		Layer* layer = voice->layer;
+		Region* region = layer->region;
+		channel_t& channel = _channels[(voice->chan - 1) & 15];
+
+		// control rate updates
+		layer->matrix.Update(channel.control, voice->mod);
+		update_envelopes(voice, frames);
+		if (has_lfo(layer))
+			update_lfos(voice);
+
+		int pitch = bend_steps(layer, channel.bend) + PitchTable::ToSteps(voice->eg_pitch + voice->lfo_pitch);
+		voice->playback.SetStep(voice->base_step * _pitch_table.Ratio(pitch));
+
+		float* out[2] = { voice_buffer(voice, 0), voice_buffer(voice, 1) };
+		voice->rendered = voice->playback.Render(out, frames, _resampler);
+
+		// the filters run over the whole block, silence the tail
+		for (int c = 0; c < voice->playback.Channels(); ++c)
+			std::fill(out[c] + voice->rendered, out[c] + frames, 0.0f);
+
+		if (layer->filter[0])
+		{
+			_cutoff[0].SetTarget(voice->index, voice->mod[MOD_CUTOFF] +
+					     region->cutoff_chanaft * channel.chanaft / 127.0f +
+					     region->cutoff_polyaft * channel.polyaft[voice->key] / 127.0f);
+			_resonance[0].SetTarget(voice->index, voice->mod[MOD_RESONANCE]);
+		}
+		if (layer->filter[1])
+		{
+			_cutoff[1].SetTarget(voice->index, voice->mod[MOD_CUTOFF2] +
+					     region->cutoff2_chanaft * channel.chanaft / 127.0f +
+					     region->cutoff2_polyaft * channel.polyaft[voice->key] / 127.0f);
+			_resonance[1].SetTarget(voice->index, voice->mod[MOD_RESONANCE2]);
+		}
+		if (layer->eq_dynamic)
+			update_eq(voice);
+	}
+
+	void
+	Engine::update_eq(Voice* voice)
+	{
+		Layer* layer = voice->layer;
+		Region* region = layer->region;
+		float velocity = voice->vel / 127.0f;
+
+		const float freq[3] = { region->eq1_freq, region->eq2_freq, region->eq3_freq };
+		const float vel2freq[3] = { region->eq1_vel2freq, region->eq2_vel2freq, region->eq3_vel2freq };
+		const float bw[3] = { region->eq1_bw, region->eq2_bw, region->eq3_bw };
+		const float gain[3] = { region->eq1_gain, region->eq2_gain, region->eq3_gain };
+		const float vel2gain[3] = { region->eq1_vel2gain, region->eq2_vel2gain, region->eq3_vel2gain };
+
+		biquad_t stages[3];
+		for (int i = 0; i < layer->eq_bands; ++i)
+		{
+			int b = layer->eq_band[i];
+			FilterBank::Equalizer(freq[b] + vel2freq[b] * velocity + voice->mod[MOD_EQ1_FREQ + b],
+					      bw[b] + voice->mod[MOD_EQ1_BW + b],
+					      gain[b] + vel2gain[b] * velocity + voice->mod[MOD_EQ1_GAIN + b],
+					      _sample_rate, stages[i]);
+		}
+		_eq.SetStages(voice->index, stages, layer->eq_bands);
+	}
+
+	void
+	Engine::filter_block(int frames)
+	{
+		for (int f = 0; f < 2; ++f)
+		{
+			bool any = false;
+			for (Voice* voice = _pool.First(); voice && !any; voice = voice->next)
+				any = voice->layer->filter[f];
+			if (!any)
+				continue;
+
+			float fraction = float(frames) / BLOCK_SIZE;
+			_cutoff[f].Process(_pool.Capacity(), fraction);
+			_resonance[f].Process(_pool.Capacity(), fraction);
+
+			// coefficients follow the smoothed modulation once per
+			// sub-block, the sub-blocks divide a short block evenly
+			int subdivisions = _cutoff[f].Subdivisions();
+			for (int k = 0; k < subdivisions; ++k)
+			{
+				int start = k * frames / subdivisions;
+				int n = (k + 1) * frames / subdivisions - start;
+				if (n <= 0)
+					continue;
+
+				for (Voice* voice = _pool.First(); voice; voice = voice->next)
+				{
+					if (!voice->layer->filter[f])
+						continue;
+					Region* region = voice->layer->region;
+					const float* eg = voice->eg_cutoff[f];
+					float cents = voice->cutoff[f] + _cutoff[f].Get(k, voice->index) +
+						eg[0] + (eg[1] - eg[0]) * (k + 1) / subdivisions;
+					float resonance = (f ? region->resonance2 : region->resonance) +
+						_resonance[f].Get(k, voice->index) + voice->eg_resonance[f];
+					if (has_lfo(voice->layer))
+					{
+						cents += lfo_offset(voice, f ? LFO_CUTOFF2 : LFO_CUTOFF, k);
+						resonance += lfo_offset(voice, f ? LFO_RESONANCE2 : LFO_RESONANCE, k);
+					}
+					_filter[f].SetParameters(voice->index, _filter_table, cents, resonance);
+				}
+
+				process_bank(_filter[f], f, start, n);
+			}
+		}
+
+		// EQ bands are set per block, no sub-block updates needed
+		bool eq = false;
+		for (Voice* voice = _pool.First(); voice && !eq; voice = voice->next)
+			eq = voice->layer->eq_bands > 0;
+		if (eq)
+			process_bank(_eq, 2, 0, frames);
+	}
+
+	void
+	Engine::process_bank(FilterBank& bank, int stage, int start, int frames)
+	{
+		const int lanes = FilterBank::LANES;
+
+		for (int p = 0; p < bank.Packs(); ++p)
+		{
+			bool used = false;
+			for (int lane = 0; lane < lanes; ++lane)
+			{
+				int slot = p * lanes + lane;
+				_lanes[lane * 2] = _lanes[lane * 2 + 1] = 0;
+				if (slot >= _pool.Capacity())
+					continue;
+
+				// stage 0 and 1 are fil and fil2, 2 is the EQ
+				Layer* layer = _pool.Get(slot)->layer;
+				if (!layer || !(stage < 2 ? layer->filter[stage] : layer->eq_bands > 0))
+					continue;
+
+				Voice* voice = _pool.Get(slot);
+				_lanes[lane * 2] = voice_buffer(voice, 0) + start;
+				if (voice->playback.Channels() == 2)
+					_lanes[lane * 2 + 1] = voice_buffer(voice, 1) + start;
+				used = true;
+			}
+			if (used)
+				bank.Process(p, &_lanes[0], frames);
+		}
+	}
+
+	bool
+	Engine::mix_voice(Voice* voice, float* left, float* right, int frames)
+	{
+		Layer* layer = voice->layer;
+		channel_t& channel = _channels[(voice->chan - 1) & 15];
+
+		float gain = voice->base_gain;
+		if (layer->xfade.HasControl())
+			gain *= layer->xfade.GetControlGain(channel.control.cc);
+		if (layer->matrix.HasTarget(MOD_GAIN))
+			gain *= std::pow(10.0f, voice->mod[MOD_GAIN] / 20.0f);
+		gain *= voice->eg_gain;
+
+		float* env = &_envelope[0];
+		voice->amp_eg.Render(env, frames);
+
+		int channels = voice->playback.Channels();
+		stereo_t stereo = layer->stereo[(channels == 2) ? 1 : 0];
+		if (layer->stereo_dynamic)
+		{
+			Region* region = layer->region;
+			stereo = StereoMixer::Lookup(channels, region->pan + voice->mod[MOD_PAN],
+						     region->width + voice->mod[MOD_WIDTH],
+						     region->position + voice->mod[MOD_POSITION]);
+		}
+
+		// ramp the gain across the block to avoid zipper noise, an
+		// amplitude LFO bends the ramp once per sub-block
+		const float* out[2] = { voice_buffer(voice, 0), voice_buffer(voice, 1) };
+		bool lfo = has_lfo(layer);
+		int subdivisions = lfo ? _lfo.Subdivisions() : 1;
+		float g = voice->gain;
+		float target = gain;
+		float loudest = g;
+		for (int k = 0; k < subdivisions; ++k)
+		{
+			int start = k * frames / subdivisions;
+			int end = (k + 1) * frames / subdivisions;
+			if (end <= start)
+				continue;
+			if (lfo)
+			{
+				float volume = lfo_offset(voice, LFO_VOLUME, k);
+				float amplitude = 1.0f + lfo_offset(voice, LFO_AMPLITUDE, k) / 100.0f;
+				target = gain * std::max(amplitude, 0.0f);
+				if (volume != 0)
+					target *= std::pow(10.0f, volume / 20.0f);
+			}
+
+			const float* in[2] = { out[0] + start, out[1] + start };
+			_mixer.Mix(stereo, in, channels, env + start, g, (target - g) / (end - start),
+				   left + start, right + start, end - start);
+			g = target;
+			loudest = std::max(loudest, target);
+		}
+		voice->gain = target;
+
+		// free the voice as soon as the amplifier envelope is silent
+		if (voice->playback.Finished() || voice->amp_eg.IsSilent())
+			return false;
+
+		// retire it once it stays below the threshold for the window
+		float spread = std::max(std::fabs(stereo.ll) + std::fabs(stereo.rl),
+					std::fabs(stereo.lr) + std::fabs(stereo.rr));
+		if (loudest * spread * voice->amp_eg.Peak() >= _cull_level)
+		{
+			voice->quiet = 0;
+			return true;
+		}
+		voice->quiet += frames;
+		if (voice->quiet < _cull_frames)
+			return true;
+		retire(voice);
+		return false;
+	}
+
+	void
+	Engine::release_voice(Voice* voice)
+	{
+		voice->sustained = false;
+
+		// one shot regions ignore note-off
+		if (voice->layer->region->loop_mode == ONE_SHOT)
+			return;
+
+		// a sustain loop plays on past its end
+		voice->released = true;
+		voice->playback.Release();
+		voice->amp_eg.Release();
+		voice->fil_eg.Release();
+		voice->pitch_eg.Release();
+		for (int i = 0; i < voice->layer->egs; ++i)
+			voice->eg[i].Release();
+	}
+
+	// offset of a parameter from the *ccN opcodes
+	static float
+	cc_offset(const boost::array<float, 128>& depth, const uint8_t* cc)
+	{
+		float offset = 0;
+		for (int i = 0; i < 128; ++i)
+			if (depth[i] != 0)
+				offset += depth[i] * cc[i] / 127.0f;
+		return offset;
+	}
+
+	void
+	Engine::start_envelopes(Voice* voice)
+	{
+		Layer* layer = voice->layer;
+		Region* region = layer->region;
+		const uint8_t* cc = _channels[(voice->chan - 1) & 15].control.cc;
+		float velocity = voice->vel / 127.0f;
+
+		float start = (region->ampeg_start + cc_offset(region->ampeg_startcc, cc)) / 100.0f;
+		float sustain = (region->ampeg_sustain + region->ampeg_vel2sustain * velocity +
+				 cc_offset(region->ampeg_sustaincc, cc)) / 100.0f;
+		voice->amp_eg.SetDAHDSR(
+			region->ampeg_delay + region->ampeg_vel2delay * velocity + cc_offset(region->ampeg_delaycc, cc),
+			std::min(std::max(start, 0.0f), 1.0f),
+			region->ampeg_attack + region->ampeg_vel2attack * velocity + cc_offset(region->ampeg_attackcc, cc),
+			region->ampeg_hold + region->ampeg_vel2hold * velocity + cc_offset(region->ampeg_holdcc, cc),
+			region->ampeg_decay + region->ampeg_vel2decay * velocity + cc_offset(region->ampeg_decaycc, cc),
+			std::min(std::max(sustain, 0.0f), 1.0f),
+			region->ampeg_release + region->ampeg_vel2release * velocity + cc_offset(region->ampeg_releasecc, cc));
+		voice->amp_eg.Start(_sample_rate);
+
+		if (layer->fileg)
+		{
+			voice->fil_depth = region->fileg_depth + region->fileg_vel2depth * velocity;
+			voice->fil_eg.SetDAHDSR(
+				region->fileg_delay + region->fileg_vel2delay * velocity,
+				region->fileg_start / 100.0f,
+				region->fileg_attack + region->fileg_vel2attack * velocity,
+				region->fileg_hold + region->fileg_vel2hold * velocity,
+				region->fileg_decay + region->fileg_vel2decay * velocity,
+				(region->fileg_sustain + region->fileg_vel2sustain * velocity) / 100.0f,
+				region->fileg_release + region->fileg_vel2release * velocity);
+			voice->fil_eg.Start(_sample_rate);
+		}
+
+		if (layer->pitcheg)
+		{
+			voice->pitch_depth = region->pitcheg_depth + region->pitcheg_vel2depth * velocity;
+			voice->pitch_eg.SetDAHDSR(
+				region->pitcheg_delay + region->pitcheg_vel2delay * velocity,
+				region->pitcheg_start / 100.0f,
+				region->pitcheg_attack + region->pitcheg_vel2attack * velocity,
+				region->pitcheg_hold + region->pitcheg_vel2hold * velocity,
+				region->pitcheg_decay + region->pitcheg_vel2decay * velocity,
+				(region->pitcheg_sustain + region->pitcheg_vel2sustain * velocity) / 100.0f,
+				region->pitcheg_release + region->pitcheg_vel2release * velocity);
+			voice->pitch_eg.Start(_sample_rate);
+		}
+
+		for (int i = 0; i < layer->egs; ++i)
+		{
+			const flex_eg_t& flex = region->eg[i];
+			Envelope& eg = voice->eg[i];
+			eg.Clear(0);
+			for (size_t p = 0; p < flex.points.size(); ++p)
+			{
+				const eg_point_t& point = flex.points[p];
+				eg.AddSegment(point.level, point.time, point.shape ? SEGMENT_EXPONENTIAL : SEGMENT_LINEAR);
+			}
+			eg.SetSustain(flex.sustain);
+			eg.Start(_sample_rate);
+		}
+
+		voice->eg_cutoff[0][1] = voice->eg_cutoff[1][1] = 0;
+		update_envelopes(voice, 0);
+	}
+
+	void
+	Engine::update_envelopes(Voice* voice, int frames)
+	{
+		Layer* layer = voice->layer;
+		Region* region = layer->region;
+
+		float pitch = 0;
+		float cutoff[2] = { 0, 0 };
+		float resonance[2] = { 0, 0 };
+		float volume = 0;
+		float gain = 1;
+
+		if (layer->pitcheg)
+			pitch += voice->pitch_eg.Advance(frames) * voice->pitch_depth;
+		if (layer->fileg)
+			cutoff[0] += voice->fil_eg.Advance(frames) * voice->fil_depth;
+
+		for (int i = 0; i < layer->egs; ++i)
+		{
+			const flex_eg_t& flex = region->eg[i];
+			float value = voice->eg[i].Advance(frames);
+			pitch += value * flex.pitch;
+			cutoff[0] += value * flex.cutoff;
+			cutoff[1] += value * flex.cutoff2;
+			resonance[0] += value * flex.resonance;
+			resonance[1] += value * flex.resonance2;
+			volume += value * flex.volume;
+			gain *= 1.0f - flex.amplitude / 100.0f * (1.0f - value);
+		}
+
+		voice->eg_pitch = pitch;
+		for (int f = 0; f < 2; ++f)
+		{
+			voice->eg_cutoff[f][0] = voice->eg_cutoff[f][1];
+			voice->eg_cutoff[f][1] = cutoff[f];
+			voice->eg_resonance[f] = resonance[f];
+		}
+		voice->eg_gain = (volume != 0) ? gain * std::pow(10.0f, volume / 20.0f) : gain;
+	}
+
+	void
+	Engine::start_lfos(Voice* voice)
+	{
+		Layer* layer = voice->layer;
+		Region* region = layer->region;
+
+		for (int i = 0; i < Voice::LFOS; ++i)
+			std::fill(voice->lfo_depth[i], voice->lfo_depth[i] + LFO_TARGETS, 0.0f);
+		voice->lfo_pitch = 0;
+		if (!has_lfo(layer))
+			return;
+
+		// SFZ 1 LFOs are sine waves
+		if (layer->amplfo)
+			_lfo.Start(lfo_slot(voice, Voice::AMPLFO), WAVE_SINE, region->amplfo_freq,
+				   region->amplfo_delay, region->amplfo_fade, 0);
+		if (layer->fillfo)
+			_lfo.Start(lfo_slot(voice, Voice::FILLFO), WAVE_SINE, region->fillfo_freq,
+				   region->fillfo_delay, region->fillfo_fade, 0);
+		if (layer->pitchlfo)
+			_lfo.Start(lfo_slot(voice, Voice::PITCHLFO), WAVE_SINE, region->pitchlfo_freq,
+				   region->pitchlfo_delay, region->pitchlfo_fade, 0);
+
+		for (int i = 0; i < layer->lfos; ++i)
+		{
+			const flex_lfo_t& flex = region->lfo[i];
+			int wave = (flex.wave >= 0 && flex.wave < WAVE_COUNT) ? flex.wave : WAVE_SINE;
+			_lfo.Start(lfo_slot(voice, Voice::PITCHLFO + 1 + i), lfo_wave_t(wave), flex.freq,
+				   flex.delay, flex.fade, flex.phase);
+		}
+
+		update_lfos(voice);
+	}
+
+	// sum of the depths of a flex LFO parameter set by controllers
+	static float
+	cc_offset(const std::vector<lfo_cc_t>& depth, const uint8_t* cc)
+	{
+		float offset = 0;
+		for (size_t i = 0; i < depth.size(); ++i)
+			offset += depth[i].depth * cc[depth[i].cc] / 127.0f;
+		return offset;
+	}
+
+	void
+	Engine::update_lfos(Voice* voice)
+	{
+		Layer* layer = voice->layer;
+		Region* region = layer->region;
+		channel_t& channel = _channels[(voice->chan - 1) & 15];
+		const uint8_t* cc = channel.control.cc;
+		float chanaft = channel.chanaft / 127.0f;
+		float polyaft = channel.polyaft[voice->key] / 127.0f;
+
+		// depth and frequency follow CC and aftertouch once per block
+		if (layer->amplfo)
+		{
+			int slot = lfo_slot(voice, Voice::AMPLFO);
+			voice->lfo_depth[Voice::AMPLFO][LFO_VOLUME] = region->amplfo_depth + voice->mod[MOD_AMPLFO_DEPTH] +
+				region->amplfo_depthchanaft * chanaft + region->amplfo_depthpolyaft * polyaft;
+			_lfo.SetFrequency(slot, region->amplfo_freq + voice->mod[MOD_AMPLFO_FREQ] +
+					  region->amplfo_freqchanaft * chanaft + region->amplfo_freqpolyaft * polyaft);
+		}
+		if (layer->fillfo)
+		{
+			int slot = lfo_slot(voice, Voice::FILLFO);
+			voice->lfo_depth[Voice::FILLFO][LFO_CUTOFF] = region->fillfo_depth + voice->mod[MOD_FILLFO_DEPTH] +
+				region->fillfo_depthchanaft * chanaft + region->fillfo_depthpolyaft * polyaft;
+			_lfo.SetFrequency(slot, region->fillfo_freq + voice->mod[MOD_FILLFO_FREQ] +
+					  region->fillfo_freqchanaft * chanaft + region->fillfo_freqpolyaft * polyaft);
+		}
+		if (layer->pitchlfo)
+		{
+			int slot = lfo_slot(voice, Voice::PITCHLFO);
+			voice->lfo_depth[Voice::PITCHLFO][LFO_PITCH] = region->pitchlfo_depth + voice->mod[MOD_PITCHLFO_DEPTH] +
+				region->pitchlfo_depthchanaft * chanaft + region->pitchlfo_depthpolyaft * polyaft;
+			_lfo.SetFrequency(slot, region->pitchlfo_freq + voice->mod[MOD_PITCHLFO_FREQ] +
+					  region->pitchlfo_freqchanaft * chanaft + region->pitchlfo_freqpolyaft * polyaft);
+		}
+
+		for (int i = 0; i < layer->lfos; ++i)
+		{
+			const flex_lfo_t& flex = region->lfo[i];
+			float* depth = voice->lfo_depth[Voice::PITCHLFO + 1 + i];
+			for (int t = 0; t < LFO_TARGETS; ++t)
+				depth[t] = flex.depth[t] + cc_offset(flex.depthcc[t], cc);
+			if (!flex.freqcc.empty())
+				_lfo.SetFrequency(lfo_slot(voice, Voice::PITCHLFO + 1 + i), flex.freq + cc_offset(flex.freqcc, cc));
+		}
+
+		// the pitch is set once per block
+		float pitch = 0;
+		for (int i = 0; i < Voice::LFOS; ++i)
+			if (voice->lfo_depth[i][LFO_PITCH] != 0)
+				pitch += voice->lfo_depth[i][LFO_PITCH] * _lfo.GetMean(lfo_slot(voice, i));
+		voice->lfo_pitch = pitch;
+	}
+
+	float
+	Engine::lfo_offset(Voice* voice, int target, int k) const
+	{
+		float offset = 0;
+		for (int i = 0; i < Voice::LFOS; ++i)
+			if (voice->lfo_depth[i][target] != 0)
+				offset += voice->lfo_depth[i][target] * _lfo.Get(k, lfo_slot(voice, i));
+		return offset;
+	}
+
+	void
+	Engine::kill_voice(Voice* voice)
+	{
+		if (voice->layer->group >= 0)
+			--_group_count[voice->layer->group];
+		if (voice->cached)
+			_cache->Stop(voice->layer->region->sample);
+		else if (voice->layer->streamed && voice->index < _streamer->Streams())
+			_streamer->Close(voice->index);
+		voice->cached = false;
+		_pool.Release(voice);
+	}
+
+	void
+	Engine::kill_voices()
+	{
+		while (_pool.First())
+			kill_voice(_pool.First());
+		_ghosts.clear();
+	}
+
+	void
+	Engine::retire(Voice* voice)
+	{
+		++_culled;
+		if (_ghosts.size() == _ghosts.capacity())
+			return;
+
+		ghost_t ghost;
+		ghost.chan = voice->chan;
+		ghost.key = voice->key;
+		ghost.remaining = voice->amp_eg.Remaining();
+		ghost.release = voice->amp_eg.ReleaseFrames();
+		ghost.sample = voice->playback.Remaining();
+
+		// a voice not yet released waits for its note or the pedal,
+		// one that never will (release triggered) is not followed
+		ghost.held = ghost.remaining < 0;
+		ghost.pedal = voice->sustained;
+		if (ghost.held && voice->layer->region->trigger == TRIGGER_RELEASE)
+			return;
+		_ghosts.push_back(ghost);
+	}
+
+	void
+	Engine::release_ghosts(uint8_t chan, int key)
+	{
+		// key -1 releases the ghosts held by the pedal
+		bool pedal = _channels[(chan - 1) & 15].sustain;
+		for (size_t i = 0; i < _ghosts.size(); ++i)
+		{
+			ghost_t& ghost = _ghosts[i];
+			if (!ghost.held || ghost.chan != chan || (key >= 0 ? ghost.key != key || ghost.pedal : !ghost.pedal))
+				continue;
+			if (key >= 0 && pedal)
+			{
+				ghost.pedal = true;
+				continue;
+			}
+			ghost.held = false;
+			ghost.remaining = ghost.release;
+		}
+	}
+
+	void
+	Engine::update_ghosts(int frames)
+	{
+		_saved_frames += double(_ghosts.size()) * frames;
+		for (size_t i = 0; i < _ghosts.size(); )
+		{
+			ghost_t& ghost = _ghosts[i];
+			if (!ghost.held)
+				ghost.remaining -= frames;
+			if (ghost.sample >= 0)
+				ghost.sample -= frames;
+			if ((!ghost.held && ghost.remaining <= 0) || (ghost.sample >= 0 && ghost.sample <= 0))
+			{
+				ghost = _ghosts.back();
+				_ghosts.pop_back();
+			}
+			else
+				++i;
+		}
+	}
+
+	void
+	Engine::pin_switch(int key, bool pin)
+	{
+		if (!_cache)
+			return;
+		const std::vector<int>& samples = _sw_samples[key & 127];
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			if (pin)
+				_cache->Pin(samples[i]);
+			else
+				_cache->Unpin(samples[i]);
+		}
+	}
+
+} // !namespace sfz
@@ -0,0 +1,560 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_ENGINE_H
+#define LIBSFZ_ENGINE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <map>
+#include <vector>
+
+#include "sfz.h"
+#include "xfade.h"
+#include "modmatrix.h"
+#include "sample.h"
+#include "stream.h"
+#include "samplecache.h"
+#include "playback.h"
+#include "filter.h"
+#include "smoother.h"
+#include "envelope.h"
+#include "lfo.h"
+#include "transport.h"
+#include "pitch.h"
+#include "stereo.h"
+#include "random.h"
+
+namespace sfz
+{
+
+	// Forward declarations
+	class Voice;
+	class VoicePool;
+	class Layer;
+	class Engine;
+
+	// Enumerations
+	enum steal_policy_t { STEAL_OLDEST, STEAL_QUIETEST, STEAL_SAME_NOTE };
+
+	/////////////////////////////////////////////////////////////
+	// class Layer
+
+	/// Engine side, compiled form of a Region
+	class Layer
+	{
+	public:
+		Layer();
+		virtual ~Layer();
+
+		/// The Region this layer was compiled from
+		Region* region;
+
+		/// Dense index of region->group, -1 if the region has none
+		int group;
+
+		/// Dense index of region->off_by, -1 if the region has none
+		int off_by;
+
+		/// State of the region sequence counter
+		int seq;
+
+		/// Decoded audio of region->sample, NULL if not loaded
+		const Sample* sample;
+
+		/// The sample is a head preloaded by the DiskStreamer
+		bool streamed;
+
+		/// Crossfaded loop end of the sample, for loop_crossfade
+		LoopSeam seam;
+
+		/// The region sets cutoff (first) and cutoff2 (second filter)
+		bool filter[2];
+
+		/// EQ bands (0-2) that can have a non-zero gain, the others
+		/// are left out of the cascade entirely
+		int eq_band[3];
+		int eq_bands;
+
+		/// EQ parameters follow CC, otherwise they are set at note-on
+		bool eq_dynamic;
+
+		/// The region uses fileg_*, pitcheg_* and this many egN_*
+		bool fileg;
+		bool pitcheg;
+		int egs;
+
+		/// The region uses amplfo_*, fillfo_*, pitchlfo_* and this many lfoN_*
+		bool amplfo;
+		bool fillfo;
+		bool pitchlfo;
+		int lfos;
+
+		/// Voice start delay: delay, delay_random (seconds) and
+		/// delay_samples, plus the delay_oncc and delay_samples_oncc of
+		/// the controllers that have one
+		struct delay_cc_t
+		{
+			int cc;
+			float seconds;
+			int samples;
+		};
+		float delay;
+		float delay_random;
+		int delay_samples;
+		std::vector<delay_cc_t> delay_cc;
+
+		/// Pitch in PitchTable steps: transpose, tune and the keycenter
+		/// offset of pitch_keytrack, then the steps per key, at full
+		/// velocity and of pitch_random
+		int pitch;
+		int pitch_keytrack;
+		int pitch_veltrack;
+		int pitch_random;
+
+		/// Placement by pan, width and position of a mono (0) and a
+		/// stereo (1) sample, recomputed every block if a controller
+		/// moves it
+		stereo_t stereo[2];
+		bool stereo_dynamic;
+
+		/// Bend range up and down (negative) and bend_step in steps
+		int bend_up;
+		int bend_down;
+		int bend_step;
+
+		/// Tempo synced start and stop, in beats of the time signature
+		int delay_beats;
+		int stop_beats;
+		int sync_beats;
+		int sync_offset;
+
+		Crossfade xfade;
+		ModMatrix matrix;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class Voice
+
+	/// A single playing instance of a Layer
+	class Voice
+	{
+	public:
+		Voice();
+		virtual ~Voice();
+
+		/// Slot of this voice in the pool
+		int index;
+
+		Layer* layer;
+		uint8_t chan;
+		uint8_t key;
+		uint8_t vel;
+
+		/// Note-on serial number, lower is older
+		unsigned long serial;
+
+		/// Gain reached by the last block before the amplifier envelope,
+		/// times the envelope it estimates the output to find the quietest voice
+		float gain;
+
+		/// Note-off received (or held back by the sustain pedal)
+		bool released;
+		bool sustained;
+
+		Playback playback;
+
+		/// Playing the whole body of the sample from the SampleCache
+		bool cached;
+
+		/// Gain and pitch fixed at note-on
+		float base_gain;
+		double base_step;
+
+		/// Cutoff of both filters after key and velocity tracking, in
+		/// cents above FilterTable::BASE_FREQUENCY
+		float cutoff[2];
+
+		/// Frames written to the voice buffer in the current block
+		int rendered;
+
+		/// Frames the voice has stayed below the cull threshold
+		int quiet;
+
+		/// Envelope generators, eg[] are the first MAX_EGS egN_*
+		enum { MAX_EGS = MAX_FLEX_EGS };
+		Envelope amp_eg;
+		Envelope fil_eg;
+		Envelope pitch_eg;
+		Envelope eg[MAX_EGS];
+
+		/// Depth of fil_eg and pitch_eg in cents, velocity applied
+		float fil_depth;
+		float pitch_depth;
+
+		/// Envelope offsets of both cutoffs (cents) at the start and
+		/// end of the block, interpolated across the sub-blocks
+		float eg_cutoff[2][2];
+
+		/// Envelope offsets of both resonances (dB), the pitch (cents)
+		/// and the gain factor
+		float eg_resonance[2];
+		float eg_pitch;
+		float eg_gain;
+
+		/// LFO slots of the voice are amplfo, fillfo, pitchlfo and then
+		/// the first MAX_LFOS lfoN_*, each with a depth per target for
+		/// the current block
+		enum { AMPLFO, FILLFO, PITCHLFO, MAX_LFOS = MAX_FLEX_LFOS, LFOS = PITCHLFO + 1 + MAX_LFOS };
+		float lfo_depth[LFOS][LFO_TARGETS];
+
+		/// LFO offset of the pitch (cents) averaged over the block
+		float lfo_pitch;
+
+		/// Current output of the layer modulation matrix
+		float mod[MOD_TARGET_COUNT];
+
+		// active list links
+		Voice* prev;
+		Voice* next;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class VoicePool
+
+	/// Preallocated, fixed-capacity set of voices
+	///
+	/// Free voices are kept on a stack and active voices on an
+	/// intrusive list in note-on order, so allocation and release are
+	/// both O(1) and never touch the heap.
+	class VoicePool
+	{
+	public:
+		VoicePool(int capacity);
+		virtual ~VoicePool();
+
+		/// Take a voice from the free stack, NULL if none is left
+		Voice* Allocate();
+
+		/// Return voice to the free stack
+		void Release(Voice* voice);
+
+		/// Release every active voice
+		void Clear();
+
+		/// Oldest active voice, the next one is reached through Voice::next
+		Voice* First() const { return _head; }
+
+		Voice* Get(int index) { return &_voices[index]; }
+
+		int Active() const { return _capacity - _free_count; }
+		int Capacity() const { return _capacity; }
+
+	private:
+		int _capacity;
+		std::vector<Voice> _voices;
+		std::vector<Voice*> _free;
+		int _free_count;
+		Voice* _head;
+		Voice* _tail;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class Engine
+
+	/// Turns MIDI events into voices playing the Regions of an Instrument
+	///
+	/// All event methods are meant to be called from the audio thread
+	/// and never allocate or lock; SetInstrument() and the other setup
+	/// methods must not run concurrently with them.
+	///
+	/// MIDI events given a frame offset and voices delayed by their
+	/// region wait in a preallocated queue ordered by time. Render()
+	/// splits its blocks where they are due, so each happens on its
+	/// exact frame. Starts and stops synced to the tempo keep their
+	/// position in quarter notes and are moved to their new frame
+	/// whenever the tempo or the host position changes.
+	class Engine
+	{
+	public:
+		Engine(int polyphony = 64);
+		virtual ~Engine();
+
+		/// Compile the regions of instrument, not real-time safe
+		void SetInstrument(Instrument* instrument);
+
+		/// Select which voice is taken when no free voice is left
+		void SetStealPolicy(steal_policy_t policy) { _steal_policy = policy; }
+
+		/// Restart the random sequence, renders of the same events
+		/// after the same seed are identical
+		void SetSeed(unsigned seed) { _random.Seed(seed); }
+
+		/// Retire voices that can no longer get above threshold (dBFS,
+		/// -inf to never cull) for window seconds. Culling is off until
+		/// a host asks for it, -90 dB and 50 ms suit most. The level of a voice is its envelope (the highest
+		/// it can still reach) times its velocity, volume, crossfade,
+		/// controller and LFO gains and its placement.
+		void SetCulling(float threshold, float window);
+
+		/// Voices retired by culling
+		unsigned long Culled() const { return _culled; }
+
+		/// Voice blocks the culled voices would still have rendered,
+		/// estimated from their envelopes, the ends of their samples and
+		/// the note-offs and sustain pedal releases that follow, in
+		/// BLOCK_SIZE frames however the blocks were split by events
+		unsigned long SavedBlocks() const { return (unsigned long) (_saved_frames / BLOCK_SIZE); }
+
+		/// Limit the number of voices playing regions of group, 0 for no limit
+		void SetGroupPolyphony(int group, int voices);
+
+		/// Set the host tempo, also used for lobpm/hibpm, a positive
+		/// frame changes it that many frames into the next Render()
+		void SetTempo(float bpm, int frame = 0);
+
+		/// Set the tempo, position and time signature of the host at
+		/// the start of the next Render(), the sample rate is the engine's
+		void SetTransport(const Transport& transport);
+
+		/// Host time at the start of the next Render()
+		const Transport& GetTransport() const { return _transport; }
+
+		/// Set the output sample rate
+		void SetSampleRate(float rate);
+
+		/// Select the interpolation used by every voice
+		void SetInterpolation(interpolation_t quality) { _resampler.SetQuality(quality); }
+
+		/// Attach decoded audio for the sample path used by regions, not real-time safe
+		void SetSample(const std::string& path, const Sample* sample);
+
+		/// Play the samples preloaded by streamer, streaming the frames
+		/// after their heads into one stream per voice, not real-time safe
+		void SetStreamer(DiskStreamer* streamer);
+
+		/// Play the sample bodies held by cache instead of streaming them
+		/// and pin the samples of the active key switch, not real-time safe
+		void SetCache(SampleCache* cache);
+
+		/// Render the next frames of all voices into left and right
+		void Render(float* left, float* right, int frames);
+
+		/// Frames between control updates
+		enum { BLOCK_SIZE = 64 };
+
+		/// Events waiting in the queue at most
+		enum { MAX_EVENTS = 4096 };
+
+		// MIDI events (chan is 1-16 like lochan/hichan), an event with a
+		// positive frame happens that many frames into the next Render()
+		void NoteOn(uint8_t chan, uint8_t key, uint8_t vel, int frame = 0);
+		void NoteOff(uint8_t chan, uint8_t key, uint8_t vel, int frame = 0);
+		void ControlChange(uint8_t chan, uint8_t cont, uint8_t val, int frame = 0);
+		void PitchBend(uint8_t chan, int bend, int frame = 0);
+		void ChannelAftertouch(uint8_t chan, uint8_t val, int frame = 0);
+		void PolyAftertouch(uint8_t chan, uint8_t key, uint8_t val, int frame = 0);
+		void ProgramChange(uint8_t chan, uint8_t prog, int frame = 0);
+
+		/// Stop all voices immediately, delayed ones included
+		void AllSoundOff();
+
+		/// Events waiting in the queue
+		int Pending() const { return _events.size(); }
+
+		VoicePool& Voices() { return _pool; }
+		const std::vector<Layer>& Layers() const { return _layers; }
+
+	protected:
+		/// MIDI state of one channel
+		struct channel_t
+		{
+			ControlState control;
+			int bend;
+			uint8_t chanaft;
+			uint8_t polyaft[128];
+			uint8_t prog;
+			uint8_t note_vel[128];
+			bool note_on[128];
+			int notes;
+			bool sustain;
+		};
+
+		/// A queued event, MIDI or the delayed start of a layer
+		enum event_type_t { EVENT_NOTE_ON, EVENT_NOTE_OFF, EVENT_CONTROL, EVENT_BEND,
+				    EVENT_CHANAFT, EVENT_POLYAFT, EVENT_PROGRAM, EVENT_TEMPO,
+				    EVENT_START, EVENT_STOP };
+		struct event_t
+		{
+			event_t(event_type_t type = EVENT_NOTE_ON, uint8_t chan = 0, uint8_t key = 0,
+				uint8_t value = 0, int data = 0, trigger_t trig = 0) :
+				time(0), order(0), type(type), chan(chan), key(key), value(value),
+				trig(trig), data(data), position(-1), offset(0), serial(0), tempo(0)
+			{
+			}
+
+			unsigned long time;
+			unsigned long order;
+			event_type_t type;
+			uint8_t chan;
+			uint8_t key;
+			uint8_t value;
+			trigger_t trig;
+			int data;
+
+			// quarter note the event is due at and the frames after it,
+			// a negative position if the event is timed in frames only
+			double position;
+			long offset;
+
+			// voice stopped by EVENT_STOP, seed of the draws of
+			// EVENT_START and tempo of EVENT_TEMPO
+			unsigned long serial;
+			double tempo;
+
+			// the earliest event is at the top of the heap
+			bool operator<(const event_t& other) const
+			{
+				return time > other.time || (time == other.time && order > other.order);
+			}
+		};
+
+		bool schedule(event_type_t type, uint8_t chan, uint8_t key, uint8_t value, int data,
+			      long frame, trigger_t trig = 0);
+		bool push(event_t& event);
+		bool at_position(event_t& event, double position, long offset);
+		void retime();
+		void dispatch(const event_t& event);
+		void drop_voice_events();
+		long start_delay(const Layer* layer, const channel_t& channel, const draws_t& draws);
+		void launch(Layer* layer, channel_t& channel, uint8_t chan, uint8_t key, uint8_t vel, trigger_t trig,
+			    const draws_t& draws);
+
+		void trigger(channel_t& channel, uint8_t chan, uint8_t key, uint8_t vel, trigger_t trig);
+		Voice* start_voice(Layer* layer, uint8_t chan, uint8_t key, uint8_t vel, const draws_t& draws);
+		static int bend_steps(const Layer* layer, int bend);
+		Voice* steal(int group, uint8_t chan, uint8_t key);
+		void release_voice(Voice* voice);
+		void kill_voice(Voice* voice);
+		void kill_voices();
+		void retire(Voice* voice);
+		void release_ghosts(uint8_t chan, int key);
+		void update_ghosts(int frames);
+		void pin_switch(int key, bool pin);
+		void bind_sample(Layer& layer);
+		void render_block(float* left, float* right, int frames);
+		void render_voice(Voice* voice, int frames);
+		void filter_block(int frames);
+		void process_bank(FilterBank& bank, int stage, int start, int frames);
+		void update_eq(Voice* voice);
+		void start_envelopes(Voice* voice);
+		void update_envelopes(Voice* voice, int frames);
+		void start_lfos(Voice* voice);
+		void update_lfos(Voice* voice);
+		float lfo_offset(Voice* voice, int target, int k) const;
+		bool has_lfo(const Layer* layer) const { return layer->amplfo || layer->fillfo || layer->pitchlfo || layer->lfos; }
+		int lfo_slot(Voice* voice, int i) const { return voice->index * Voice::LFOS + i; }
+		bool mix_voice(Voice* voice, float* left, float* right, int frames);
+		float* voice_buffer(Voice* voice, int channel) { return &_buffer[(voice->index * 2 + channel) * BLOCK_SIZE]; }
+
+		VoicePool _pool;
+		steal_policy_t _steal_policy;
+
+		// event queue, a heap in preallocated storage, and the frame
+		// the next Render() starts at
+		std::vector<event_t> _events;
+		unsigned long _event_order;
+		unsigned long _time;
+
+		unsigned long _serial;
+
+		// culling, and what is left of the culled voices: held by the
+		// note or the pedal until released, then frames to go
+		struct ghost_t
+		{
+			uint8_t chan;
+			uint8_t key;
+			bool held;
+			bool pedal;
+			long remaining;
+			long release;
+			long sample;
+		};
+		float _cull_level;
+		int _cull_frames;
+		float _cull_window;
+		unsigned long _culled;
+		double _saved_frames;
+		std::vector<ghost_t> _ghosts;
+		Random _random;
+		Transport _transport;
+		float _sample_rate;
+
+		Resampler _resampler;
+
+		// per voice output of the current block, [voice][channel][frame]
+		std::vector<float> _buffer;
+
+		// amplitude envelope of the voice being mixed
+		std::vector<float> _envelope;
+
+		// fil and fil2, cutoff and resonance modulation smoothed per voice
+		FilterTable _filter_table;
+		PitchTable _pitch_table;
+		StereoMixer _mixer;
+		FilterBank _filter[2];
+		FilterBank _eq;
+		Smoother _cutoff[2];
+		Smoother _resonance[2];
+		std::vector<float*> _lanes;
+
+		// LFOs of all voices, Voice::LFOS slots per voice
+		LfoBank _lfo;
+
+		// host supplied audio by SampleStore id
+		std::map<int, const Sample*> _samples;
+		DiskStreamer* _streamer;
+		SampleCache* _cache;
+
+		Instrument* _instrument;
+		CrossfadeTables _xfade_tables;
+		std::vector<Layer> _layers;
+		std::vector<int> _by_key[128];
+
+		// group polyphony, indexed by dense group index
+		std::map<int, int> _group_limit_config;
+		std::vector<int> _group_limit;
+		std::vector<int> _group_count;
+
+		channel_t _channels[16];
+
+		// key switch state
+		int _sw_lokey;
+		int _sw_hikey;
+		bool _sw[128];
+		uint8_t _last_sw_key;
+		uint8_t _prev_key;
+
+		// streamed samples of the regions selected by each sw_last key,
+		// pinned in the cache while the key is the last one switched to
+		std::vector<int> _sw_samples[128];
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_ENGINE_H
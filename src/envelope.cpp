@@ -0,0 +1,261 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "envelope.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Envelope
+
+	const float Envelope::SILENCE = 0.0001f;
+
+	Envelope::Envelope() :
+		_count(0),
+		_sustain(-1),
+		_initial(0),
+		_sample_rate(44100),
+		_current(0),
+		_remaining(0),
+		_holding(false),
+		_released(false),
+		_value(0),
+		_ratio(1),
+		_delta(0)
+	{
+	}
+
+	Envelope::~Envelope()
+	{
+	}
+
+	void
+	Envelope::Clear(float initial)
+	{
+		_count = 0;
+		_sustain = -1;
+		_initial = initial;
+		_value = initial;
+		_current = 0;
+	}
+
+	void
+	Envelope::AddSegment(float level, float time, segment_shape_t shape)
+	{
+		if (_count == MAX_SEGMENTS)
+			return;
+
+		segment_t& segment = _segment[_count++];
+		segment.level = level;
+		segment.time = (time > 0) ? time : 0;
+		segment.shape = shape;
+	}
+
+	void
+	Envelope::SetDAHDSR(float delay, float start, float attack, float hold,
+			    float decay, float sustain, float release)
+	{
+		Clear(0);
+		AddSegment(0, delay, SEGMENT_LINEAR);
+		AddSegment(start, 0, SEGMENT_LINEAR);
+		AddSegment(1, attack, SEGMENT_LINEAR);
+		AddSegment(1, hold, SEGMENT_LINEAR);
+		AddSegment(sustain, decay, SEGMENT_EXPONENTIAL);
+		AddSegment(0, release, SEGMENT_EXPONENTIAL);
+		SetSustain(4);
+	}
+
+	void
+	Envelope::Start(float sample_rate)
+	{
+		_sample_rate = sample_rate;
+		_released = false;
+		_value = _initial;
+		enter(0);
+	}
+
+	void
+	Envelope::Release()
+	{
+		if (_released)
+			return;
+		_released = true;
+
+		// without a sustain segment the envelope just runs on
+		if (_sustain >= 0 && _current <= _sustain)
+			enter(_sustain + 1);
+	}
+
+	void
+	Envelope::Render(float* out, int frames)
+	{
+		int i = 0;
+		while (i < frames)
+		{
+			if (_holding || Finished())
+			{
+				for (; i < frames; ++i)
+					out[i] = _value;
+				break;
+			}
+
+			int n = (_remaining < frames - i) ? int(_remaining) : frames - i;
+			float value = _value;
+			for (int k = 0; k < n; ++k)
+			{
+				value = value * _ratio + _delta;
+				out[i + k] = value;
+			}
+			_value = value;
+			_remaining -= n;
+			i += n;
+
+			if (!_remaining)
+			{
+				// land exactly on the level, not on the accumulated value
+				_value = _segment[_current].level;
+				out[i - 1] = _value;
+				enter(_current + 1);
+			}
+		}
+	}
+
+	float
+	Envelope::Advance(int frames)
+	{
+		while (frames > 0 && !_holding && !Finished())
+		{
+			int n = (_remaining < frames) ? int(_remaining) : frames;
+			if (_ratio == 1.0f)
+				_value += n * _delta;
+			else
+				_value *= std::pow(_ratio, float(n));
+			_remaining -= n;
+			frames -= n;
+
+			if (!_remaining)
+			{
+				_value = _segment[_current].level;
+				enter(_current + 1);
+			}
+		}
+		return _value;
+	}
+
+	bool
+	Envelope::IsSilent() const
+	{
+		return (_holding || Finished()) && std::fabs(_value) < SILENCE;
+	}
+
+	float
+	Envelope::Peak() const
+	{
+		float peak = std::fabs(_value);
+		for (int i = _current; i < _count; ++i)
+			peak = std::max(peak, std::fabs(_segment[i].level));
+		return peak;
+	}
+
+	long
+	Envelope::Remaining() const
+	{
+		if (Finished())
+			return 0;
+
+		// a silent sustain level is the end, see IsSilent()
+		int last = _count - 1;
+		if (_sustain >= 0 && !_released && _current <= _sustain)
+		{
+			if (std::fabs(_segment[_sustain].level) >= SILENCE)
+				return -1;
+			if (_holding)
+				return 0;
+			last = _sustain;
+		}
+
+		long frames = _remaining;
+		for (int i = _current + 1; i <= last; ++i)
+			frames += long(_segment[i].time * _sample_rate + 0.5f);
+		return frames;
+	}
+
+	long
+	Envelope::ReleaseFrames() const
+	{
+		long frames = 0;
+		for (int i = _sustain + 1; _sustain >= 0 && i < _count; ++i)
+			frames += long(_segment[i].time * _sample_rate + 0.5f);
+		return frames;
+	}
+
+	void
+	Envelope::enter(int segment)
+	{
+		_holding = false;
+
+		// hold at the end of the sustain segment until released
+		if (segment == _sustain + 1 && _sustain >= 0 && !_released)
+		{
+			_current = _sustain;
+			_holding = true;
+			return;
+		}
+
+		_current = segment;
+		if (Finished())
+			return;
+
+		const segment_t& s = _segment[_current];
+		_remaining = long(s.time * _sample_rate + 0.5f);
+		if (_remaining <= 0)
+		{
+			// zero length segments jump to their level
+			_value = s.level;
+			enter(_current + 1);
+			return;
+		}
+
+		// exponential ramps need both ends on the same side of zero,
+		// zero itself is approached as SILENCE
+		float from = _value;
+		float to = s.level;
+		if (s.shape == SEGMENT_EXPONENTIAL && from * to >= 0 && from != to)
+		{
+			float sign = (from + to < 0) ? -1.0f : 1.0f;
+			if (std::fabs(from) < SILENCE) from = sign * SILENCE;
+			if (std::fabs(to) < SILENCE) to = sign * SILENCE;
+			_value = from;
+			_ratio = std::pow(to / from, 1.0f / _remaining);
+			_delta = 0;
+		}
+		else
+		{
+			_ratio = 1;
+			_delta = (to - from) / _remaining;
+		}
+	}
+
+} // !namespace sfz
@@ -0,0 +1,130 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_ENVELOPE_H
+#define LIBSFZ_ENVELOPE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+namespace sfz
+{
+
+	// Enumerations
+	enum segment_shape_t { SEGMENT_LINEAR, SEGMENT_EXPONENTIAL };
+
+	/////////////////////////////////////////////////////////////
+	// struct segment_t
+
+	/// Ramp to level over time seconds
+	struct segment_t
+	{
+		float level;
+		float time;
+		segment_shape_t shape;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class Envelope
+
+	/// Envelope generator playing a list of segments
+	///
+	/// Each segment ramps from the level the previous one ended at to
+	/// its own level, either linearly or exponentially (a constant
+	/// ratio per sample, a straight line in dB). The ramp is set up
+	/// when a segment is entered and then stepped in closed form, one
+	/// add or multiply per sample in Render() and a single step for a
+	/// whole block in Advance(). The sustain segment, if any, is held
+	/// at its level until Release(), which moves on to the segment
+	/// after it from the current value.
+	class Envelope
+	{
+	public:
+		enum { MAX_SEGMENTS = 16 };
+
+		/// Level below which the output counts as silence (-80 dB)
+		static const float SILENCE;
+
+		Envelope();
+		virtual ~Envelope();
+
+		/// Remove all segments, the envelope starts from initial
+		void Clear(float initial = 0);
+
+		/// Append a segment, ignored when MAX_SEGMENTS are used
+		void AddSegment(float level, float time, segment_shape_t shape);
+
+		/// Hold at the end of segment until Release(), -1 for none
+		void SetSustain(int segment) { _sustain = segment; }
+
+		/// Set up delay, attack, hold, decay, sustain and release segments
+		/// (times in seconds, start and sustain levels 0-1)
+		void SetDAHDSR(float delay, float start, float attack, float hold,
+			       float decay, float sustain, float release);
+
+		/// Restart from the first segment
+		void Start(float sample_rate);
+
+		/// Leave the sustain segment (or the segments before it)
+		void Release();
+
+		/// Write the values of the next frames to out
+		void Render(float* out, int frames);
+
+		/// Skip the next frames, returns the value reached
+		float Advance(int frames);
+
+		float Value() const { return _value; }
+
+		/// Return true if every segment is done
+		bool Finished() const { return _current >= _count; }
+
+		/// Return true if the output is silent and will stay so
+		bool IsSilent() const;
+
+		/// Highest level (absolute) the envelope can still reach, the
+		/// current value included
+		float Peak() const;
+
+		/// Frames until Finished() or silent for good, -1 while an
+		/// audible sustain segment is ahead or held
+		long Remaining() const;
+
+		/// Frames of the segments after the sustain segment
+		long ReleaseFrames() const;
+
+	private:
+		void enter(int segment);
+
+		segment_t _segment[MAX_SEGMENTS];
+		int _count;
+		int _sustain;
+		float _initial;
+		float _sample_rate;
+
+		int _current;
+		long _remaining;
+		bool _holding;
+		bool _released;
+		float _value;
+		float _ratio;   // value = value * ratio + delta per sample,
+		float _delta;   // ratio is 1 on linear segments, delta 0 on exponential
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_ENVELOPE_H
@@ -0,0 +1,451 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "filter.h"
+#include "filter_kernels.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace sfz
+{
+
+	// frames interleaved per call to the kernel
+	static const int CHUNK = 256;
+
+	static void
+	identity(biquad_t& stage)
+	{
+		stage.b0 = 1; stage.b1 = 0; stage.b2 = 0;
+		stage.a1 = 0; stage.a2 = 0;
+	}
+
+	// first order sections through the bilinear transform
+	static void
+	one_pole(filter_t type, float k, biquad_t& stage)
+	{
+		float n = 1.0f / (1.0f + k);
+		stage.b2 = stage.a2 = 0;
+		stage.a1 = (k - 1.0f) * n;
+		switch (type)
+		{
+		case HPF_1P:
+			stage.b0 = n;
+			stage.b1 = -n;
+			break;
+		case APF_1P:
+			stage.b0 = stage.a1;
+			stage.b1 = 1;
+			break;
+		default:
+			stage.b0 = k * n;
+			stage.b1 = k * n;
+			break;
+		}
+	}
+
+	// second order sections from the RBJ audio EQ cookbook
+	static void
+	two_pole(filter_t type, float w0, float q, float gain_db, biquad_t& stage)
+	{
+		float cs = std::cos(w0);
+		float alpha = std::sin(w0) / (2.0f * q);
+		float b0, b1, b2, a0, a1, a2;
+
+		a1 = -2.0f * cs;
+		switch (type)
+		{
+		case HPF_2P: case HPF_4P: case HPF_6P:
+			b0 = b2 = (1.0f + cs) * 0.5f;
+			b1 = -(1.0f + cs);
+			a0 = 1.0f + alpha; a2 = 1.0f - alpha;
+			break;
+		case BPF_2P:
+			b0 = alpha; b1 = 0; b2 = -alpha;
+			a0 = 1.0f + alpha; a2 = 1.0f - alpha;
+			break;
+		case BRF_1P: case BRF_2P:
+			b0 = b2 = 1.0f;
+			b1 = -2.0f * cs;
+			a0 = 1.0f + alpha; a2 = 1.0f - alpha;
+			break;
+		case PKF_2P:
+		{
+			float A = std::pow(10.0f, gain_db / 40.0f);
+			b0 = 1.0f + alpha * A; b1 = -2.0f * cs; b2 = 1.0f - alpha * A;
+			a0 = 1.0f + alpha / A; a2 = 1.0f - alpha / A;
+			break;
+		}
+		default:
+			b0 = b2 = (1.0f - cs) * 0.5f;
+			b1 = 1.0f - cs;
+			a0 = 1.0f + alpha; a2 = 1.0f - alpha;
+			break;
+		}
+
+		stage.b0 = b0 / a0; stage.b1 = b1 / a0; stage.b2 = b2 / a0;
+		stage.a1 = a1 / a0; stage.a2 = a2 / a0;
+	}
+
+	// types whose coefficients depend on resonance
+	static bool
+	resonant(filter_t type)
+	{
+		switch (type)
+		{
+		case LPF_1P: case HPF_1P: case BPF_1P: case BRF_1P: case APF_1P:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class FilterTable
+
+	const float FilterTable::BASE_FREQUENCY = 8.175799f;
+
+	FilterTable::FilterTable() :
+		_sample_rate(44100),
+		_cents_points(0)
+	{
+		for (int t = 0; t < FILTER_TYPES; ++t)
+			_prepared[t] = false;
+	}
+
+	FilterTable::~FilterTable()
+	{
+	}
+
+	void
+	FilterTable::SetSampleRate(float rate)
+	{
+		if (rate == _sample_rate && _cents_points)
+			return;
+
+		_sample_rate = rate;
+		_cents_points = 0;
+		for (int t = 0; t < FILTER_TYPES; ++t)
+			if (_prepared[t])
+				build(filter_t(t));
+	}
+
+	void
+	FilterTable::Prepare(filter_t type)
+	{
+		if (!_prepared[type])
+			build(type);
+		_prepared[type] = true;
+	}
+
+	void
+	FilterTable::build(filter_t type)
+	{
+		// the grid ends at the cutoff clamp of FilterBank::Design()
+		if (!_cents_points)
+		{
+			float top = 1200.0f * std::log(_sample_rate * 0.5f * 0.95f / BASE_FREQUENCY) / std::log(2.0f);
+			_cents_points = int(top / CENTS_STEP) + 2;
+		}
+
+		int stages = FilterBank::Stages(type);
+		int res_points = resonant(type) ? MAX_RESONANCE / RESONANCE_STEP + 1 : 1;
+
+		std::vector<biquad_t>& table = _table[type];
+		table.resize(res_points * _cents_points * stages);
+		for (int r = 0; r < res_points; ++r)
+			for (int c = 0; c < _cents_points; ++c)
+				FilterBank::Design(type, ToHz(float(c * CENTS_STEP)), float(r * RESONANCE_STEP),
+						   _sample_rate, &table[(r * _cents_points + c) * stages]);
+	}
+
+	int
+	FilterTable::Lookup(filter_t type, float cents, float resonance, biquad_t* stages) const
+	{
+		if (!_prepared[type])
+			return 0;
+
+		int count = FilterBank::Stages(type);
+		const biquad_t* table = &_table[type][0];
+
+		float c = cents / CENTS_STEP;
+		if (c < 0) c = 0;
+		if (c > _cents_points - 1) c = float(_cents_points - 1);
+		int ci = int(c);
+		if (ci > _cents_points - 2) ci = _cents_points - 2;
+		float cf = c - ci;
+
+		int ri = 0;
+		float rf = 0;
+		if (resonant(type))
+		{
+			if (resonance < 0 || resonance > MAX_RESONANCE)
+				return 0;
+			float r = resonance / RESONANCE_STEP;
+			ri = int(r);
+			if (ri > MAX_RESONANCE / RESONANCE_STEP - 1) ri = MAX_RESONANCE / RESONANCE_STEP - 1;
+			rf = r - ri;
+		}
+
+		// bilinear interpolation of every coefficient
+		const float* p00 = &table[(ri * _cents_points + ci) * count].b0;
+		const float* p01 = p00 + count * 5;
+		const float* p10 = p00 + (resonant(type) ? _cents_points * count * 5 : 0);
+		const float* p11 = p10 + count * 5;
+		float* out = &stages[0].b0;
+		for (int k = 0; k < count * 5; ++k)
+		{
+			float lo = p00[k] + (p01[k] - p00[k]) * cf;
+			float hi = p10[k] + (p11[k] - p10[k]) * cf;
+			out[k] = lo + (hi - lo) * rf;
+		}
+
+		return count;
+	}
+
+	float
+	FilterTable::ToHz(float cents)
+	{
+		return BASE_FREQUENCY * std::pow(2.0f, cents / 1200.0f);
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class FilterBank
+
+	FilterBank::FilterBank(int capacity) :
+		_sample_rate(44100),
+		_packs(0),
+		_interleaved(LANES * CHUNK)
+	{
+#if defined(LIBSFZ_HAVE_AVX2)
+		if (simd::HasAVX2())
+			_process = kernels::avx2_filter();
+		else
+#endif
+			_process = &kernels::process_pack<simd::native_t>;
+
+		Resize(capacity);
+	}
+
+	FilterBank::~FilterBank()
+	{
+	}
+
+	void
+	FilterBank::Resize(int capacity)
+	{
+		_packs = (capacity + LANES - 1) / LANES;
+		_pack.resize(_packs);
+		_type.assign(_packs * LANES, LPF_2P);
+		for (int slot = 0; slot < _packs * LANES; ++slot)
+			Reset(slot, LPF_2P);
+	}
+
+	void
+	FilterBank::Reset(int slot, filter_t type)
+	{
+		pack_t& pack = _pack[slot / LANES];
+		int lane = slot % LANES;
+
+		_type[slot] = type;
+		pack.stages[lane] = Stages(type);
+		for (int st = 0; st < MAX_STAGES; ++st)
+		{
+			pack.b0[st][lane] = 1; pack.b1[st][lane] = 0; pack.b2[st][lane] = 0;
+			pack.a1[st][lane] = 0; pack.a2[st][lane] = 0;
+			for (int c = 0; c < 2; ++c)
+				pack.s1[c][st][lane] = pack.s2[c][st][lane] = 0;
+		}
+	}
+
+	void
+	FilterBank::SetParameters(int slot, float cutoff, float resonance)
+	{
+		biquad_t stages[MAX_STAGES];
+		int count = Design(_type[slot], cutoff, resonance, _sample_rate, stages);
+		SetStages(slot, stages, count);
+	}
+
+	void
+	FilterBank::SetParameters(int slot, const FilterTable& table, float cents, float resonance)
+	{
+		biquad_t stages[MAX_STAGES];
+		int count = table.Lookup(_type[slot], cents, resonance, stages);
+		if (!count)
+			count = Design(_type[slot], FilterTable::ToHz(cents), resonance, _sample_rate, stages);
+		SetStages(slot, stages, count);
+	}
+
+	void
+	FilterBank::SetStages(int slot, const biquad_t* stages, int count)
+	{
+		pack_t& pack = _pack[slot / LANES];
+		int lane = slot % LANES;
+
+		pack.stages[lane] = count;
+		for (int st = 0; st < MAX_STAGES; ++st)
+		{
+			biquad_t stage;
+			if (st < count)
+				stage = stages[st];
+			else
+				identity(stage);
+
+			pack.b0[st][lane] = stage.b0;
+			pack.b1[st][lane] = stage.b1;
+			pack.b2[st][lane] = stage.b2;
+			pack.a1[st][lane] = stage.a1;
+			pack.a2[st][lane] = stage.a2;
+		}
+	}
+
+	void
+	FilterBank::Process(int pack_index, float* const* in, int frames)
+	{
+		pack_t& pack = _pack[pack_index];
+
+		int stages = 0;
+		bool used[2] = { false, false };
+		for (int lane = 0; lane < LANES; ++lane)
+		{
+			if (!in[lane * 2] && !in[lane * 2 + 1])
+				continue;
+			if (pack.stages[lane] > stages)
+				stages = pack.stages[lane];
+			used[0] = used[0] || in[lane * 2];
+			used[1] = used[1] || in[lane * 2 + 1];
+		}
+
+		float* data = &_interleaved[0];
+		for (int c = 0; c < 2; ++c)
+		{
+			if (!used[c])
+				continue;
+
+			for (int offset = 0; offset < frames; offset += CHUNK)
+			{
+				int n = (frames - offset < CHUNK) ? frames - offset : CHUNK;
+
+				for (int lane = 0; lane < LANES; ++lane)
+				{
+					const float* src = in[lane * 2 + c];
+					if (src)
+						for (int i = 0; i < n; ++i)
+							data[i * LANES + lane] = src[offset + i];
+					else
+						for (int i = 0; i < n; ++i)
+							data[i * LANES + lane] = 0.0f;
+				}
+
+				_process(pack, c, stages, data, n);
+
+				for (int lane = 0; lane < LANES; ++lane)
+				{
+					float* dst = in[lane * 2 + c];
+					if (dst)
+						for (int i = 0; i < n; ++i)
+							dst[offset + i] = data[i * LANES + lane];
+				}
+			}
+		}
+	}
+
+	int
+	FilterBank::Stages(filter_t type)
+	{
+		switch (type)
+		{
+		case BPF_1P: case LPF_4P: case HPF_4P:
+			return 2;
+		case LPF_6P: case HPF_6P:
+			return 3;
+		default:
+			return 1;
+		}
+	}
+
+	int
+	FilterBank::Design(filter_t type, float cutoff, float resonance,
+			   float sample_rate, biquad_t* stages)
+	{
+		// keep the cutoff inside the range the bilinear transform handles
+		float nyquist = sample_rate * 0.5f;
+		if (cutoff < 10.0f) cutoff = 10.0f;
+		if (cutoff > nyquist * 0.95f) cutoff = nyquist * 0.95f;
+
+		const float pi = 3.14159265358979f;
+		float w0 = 2.0f * pi * cutoff / sample_rate;
+		float r = std::pow(10.0f, resonance / 20.0f);
+
+		switch (type)
+		{
+		case LPF_1P: case HPF_1P: case APF_1P:
+			one_pole(type, std::tan(w0 * 0.5f), stages[0]);
+			return 1;
+		case BPF_1P:
+		{
+			float k = std::tan(w0 * 0.5f);
+			one_pole(HPF_1P, k, stages[0]);
+			one_pole(LPF_1P, k, stages[1]);
+			return 2;
+		}
+		case BRF_1P:
+			// gentle notch standing in for the first order band reject
+			two_pole(BRF_1P, w0, 0.5f, 0, stages[0]);
+			return 1;
+		case PKF_2P:
+			// resonance is the peak gain
+			two_pole(PKF_2P, w0, 0.7071f, resonance, stages[0]);
+			return 1;
+		case LPF_2P: case HPF_2P: case BPF_2P: case BRF_2P:
+			two_pole(type, w0, 0.7071f * r, 0, stages[0]);
+			return 1;
+		case LPF_4P: case HPF_4P:
+			// Butterworth pole pairs, resonance raises the sharper one
+			two_pole(type, w0, 0.5412f, 0, stages[0]);
+			two_pole(type, w0, 1.3066f * r, 0, stages[1]);
+			return 2;
+		case LPF_6P: case HPF_6P:
+			two_pole(type, w0, 0.5176f, 0, stages[0]);
+			two_pole(type, w0, 0.7071f, 0, stages[1]);
+			two_pole(type, w0, 1.9319f * r, 0, stages[2]);
+			return 3;
+		}
+
+		identity(stages[0]);
+		return 1;
+	}
+
+	void
+	FilterBank::Equalizer(float freq, float bandwidth, float gain,
+			      float sample_rate, biquad_t& stage)
+	{
+		float nyquist = sample_rate * 0.5f;
+		if (freq < 10.0f) freq = 10.0f;
+		if (freq > nyquist * 0.95f) freq = nyquist * 0.95f;
+		if (bandwidth < 0.01f) bandwidth = 0.01f;
+
+		// bandwidth in octaves to Q, analog prototype
+		float q = 1.0f / (2.0f * std::sinh(0.5f * std::log(2.0f) * bandwidth));
+		two_pole(PKF_2P, 2.0f * 3.14159265358979f * freq / sample_rate, q, gain, stage);
+	}
+
+} // !namespace sfz
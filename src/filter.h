@@ -0,0 +1,189 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_FILTER_H
+#define LIBSFZ_FILTER_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <vector>
+
+#include "sfz.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// struct biquad_t
+
+	/// Normalized biquad coefficients (a0 = 1)
+	struct biquad_t
+	{
+		float b0, b1, b2, a1, a2;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class FilterTable
+
+	/// Precomputed filter coefficients shared by all voices
+	///
+	/// Coefficients of each filter_t are sampled on a grid of cutoff
+	/// (cents above BASE_FREQUENCY, every CENTS_STEP) and resonance
+	/// (dB from 0 to MAX_RESONANCE, every RESONANCE_STEP) and read
+	/// back with bilinear interpolation, so a parameter update costs
+	/// a few multiply-adds instead of tan/sin/cos/pow.
+	///
+	/// Accuracy, measured for every type at 44.1 to 96 kHz as the
+	/// largest deviation of the response from FilterBank::Design(),
+	/// relative to its peak gain:
+	///
+	///   cutoff        resonance < 12 dB   up to 40 dB
+	///   1 kHz and up  0.1 dB              0.3 dB
+	///   300-1000 Hz   0.1 dB              0.2 dB
+	///   100-300 Hz    0.2 dB              2.2 dB
+	///   20-100 Hz     1.0 dB              5.2 dB
+	///
+	/// The large figures at low cutoffs and high resonance are single
+	/// precision coefficients, whose poles sit close to the unit
+	/// circle there: Design() itself is off by as much (4.7 dB for
+	/// lpf_2p at 20-100 Hz) from a double precision design.
+	///
+	/// Only the tables of types passed to Prepare() are built, about
+	/// 0.6 MB per stage at 48 kHz; they are rebuilt when the rate
+	/// changes.
+	class FilterTable
+	{
+	public:
+		enum { FILTER_TYPES = HPF_6P + 1 };
+		enum { CENTS_STEP = 10, RESONANCE_STEP = 2, MAX_RESONANCE = 40 };
+
+		/// Frequency of cent 0, MIDI note 0
+		static const float BASE_FREQUENCY;
+
+		FilterTable();
+		virtual ~FilterTable();
+
+		/// Rebuild the prepared tables for rate, not real-time safe
+		void SetSampleRate(float rate);
+
+		/// Build the table of type, not real-time safe
+		void Prepare(filter_t type);
+
+		/// Interpolate the stages of type at cutoff (cents) and
+		/// resonance (dB), returns the number of stages or 0 if the
+		/// table is not prepared or resonance is outside of it
+		int Lookup(filter_t type, float cents, float resonance, biquad_t* stages) const;
+
+		float SampleRate() const { return _sample_rate; }
+
+		/// Convert cents above BASE_FREQUENCY to Hz
+		static float ToHz(float cents);
+
+	private:
+		void build(filter_t type);
+
+		float _sample_rate;
+		int _cents_points;
+		bool _prepared[FILTER_TYPES];
+
+		// [resonance][cents][stage] per type
+		std::vector<biquad_t> _table[FILTER_TYPES];
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class FilterBank
+
+	/// Filters of many voices processed side by side
+	///
+	/// Voices are grouped in packs of LANES; inside a pack every voice
+	/// is one SIMD lane and samples are processed interleaved, so one
+	/// vector instruction advances the filters of 4 (SSE2, NEON) or 8
+	/// (AVX2) voices. Every filter_t is realized as a cascade of up to
+	/// MAX_STAGES biquads, lanes needing fewer stages run identity
+	/// stages. Coefficients are only set at control rate.
+	class FilterBank
+	{
+	public:
+		enum { LANES = 8, MAX_STAGES = 3 };
+
+		FilterBank(int capacity = 0);
+		virtual ~FilterBank();
+
+		/// Allocate storage for capacity slots, not real-time safe
+		void Resize(int capacity);
+
+		void SetSampleRate(float rate) { _sample_rate = rate; }
+
+		/// Clear the state of slot and select its filter type
+		void Reset(int slot, filter_t type);
+
+		/// Set cutoff (Hz) and resonance (dB) of slot
+		void SetParameters(int slot, float cutoff, float resonance);
+
+		/// Set cutoff (cents above FilterTable::BASE_FREQUENCY) and
+		/// resonance (dB) of slot through table, falling back to the
+		/// exact design for parameters outside of it
+		void SetParameters(int slot, const FilterTable& table, float cents, float resonance);
+
+		/// Replace the stages of slot with count precomputed biquads
+		void SetStages(int slot, const biquad_t* stages, int count);
+
+		/// Filter one pack in place, in[lane * 2 + channel] may be NULL
+		void Process(int pack, float* const* in, int frames);
+
+		/// Number of stages needed by type
+		static int Stages(filter_t type);
+
+		/// Compute the stages of type, returns the number of stages
+		static int Design(filter_t type, float cutoff, float resonance,
+				  float sample_rate, biquad_t* stages);
+
+		/// Compute a peaking EQ band, bandwidth in octaves and gain in dB
+		static void Equalizer(float freq, float bandwidth, float gain,
+				      float sample_rate, biquad_t& stage);
+
+		int Packs() const { return _packs; }
+
+		/// Per pack storage, one array of LANES values per field
+		struct pack_t
+		{
+			float b0[MAX_STAGES][LANES];
+			float b1[MAX_STAGES][LANES];
+			float b2[MAX_STAGES][LANES];
+			float a1[MAX_STAGES][LANES];
+			float a2[MAX_STAGES][LANES];
+			float s1[2][MAX_STAGES][LANES];
+			float s2[2][MAX_STAGES][LANES];
+			int stages[LANES];
+		};
+
+		/// Filter frames of interleaved [frame][lane] data through a pack
+		typedef void (*process_fn)(pack_t& pack, int channel, int stages, float* data, int frames);
+
+	private:
+		float _sample_rate;
+		int _packs;
+		std::vector<pack_t> _pack;
+		std::vector<filter_t> _type;
+		std::vector<float> _interleaved;
+		process_fn _process;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_FILTER_H
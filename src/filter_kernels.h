@@ -0,0 +1,85 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_FILTER_KERNELS_H
+#define LIBSFZ_FILTER_KERNELS_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Biquad cascade kernels shared by the per instruction set translation
+// units. Not part of the public interface.
+
+#include "filter.h"
+#include "simd.h"
+
+namespace sfz
+{
+namespace kernels
+{
+
+#if defined(LIBSFZ_HAVE_AVX2)
+	/// Pack kernel compiled for AVX2, defined in filter_avx2.cpp
+	FilterBank::process_fn avx2_filter();
+#endif
+
+	// one copy per translation unit, see simd.h
+	namespace
+	{
+
+	// transposed direct form II, one stage at a time over all frames
+	template<class S>
+	void
+	process_pack(FilterBank::pack_t& pack, int channel, int stages, float* data, int frames)
+	{
+		typedef typename S::V V;
+		const int lanes = FilterBank::LANES;
+
+		for (int st = 0; st < stages; ++st)
+		{
+			for (int j = 0; j < lanes; j += S::width)
+			{
+				const V b0 = S::loadu(&pack.b0[st][j]);
+				const V b1 = S::loadu(&pack.b1[st][j]);
+				const V b2 = S::loadu(&pack.b2[st][j]);
+				const V a1 = S::loadu(&pack.a1[st][j]);
+				const V a2 = S::loadu(&pack.a2[st][j]);
+				V s1 = S::loadu(&pack.s1[channel][st][j]);
+				V s2 = S::loadu(&pack.s2[channel][st][j]);
+
+				float* x = data + j;
+				for (int i = 0; i < frames; ++i, x += lanes)
+				{
+					V in = S::loadu(x);
+					V y = S::madd(b0, in, s1);
+					s1 = S::sub(S::madd(b1, in, s2), S::mul(a1, y));
+					s2 = S::sub(S::mul(b2, in), S::mul(a2, y));
+					S::storeu(x, y);
+				}
+
+				S::storeu(&pack.s1[channel][st][j], s1);
+				S::storeu(&pack.s2[channel][st][j], s2);
+			}
+		}
+	}
+
+	} // !namespace
+
+} // !namespace kernels
+} // !namespace sfz
+
+#endif // !LIBSFZ_FILTER_KERNELS_H
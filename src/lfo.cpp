@@ -0,0 +1,174 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "lfo.h"
+#include "lfo_kernels.h"
+
+#include <cmath>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// wavetables
+
+	static float waves[WAVE_COUNT * (LfoBank::TABLE_SIZE + 1)];
+
+	static float
+	wave_value(int wave, float p)
+	{
+		switch (wave)
+		{
+		case WAVE_TRIANGLE:
+			return (p < 0.25f) ? 4 * p : (p < 0.75f) ? 2 - 4 * p : 4 * p - 4;
+		case WAVE_SINE:
+			return std::sin(2 * 3.14159265358979f * p);
+		case WAVE_PULSE75:
+			return (p < 0.75f) ? 1 : -1;
+		case WAVE_SQUARE:
+			return (p < 0.5f) ? 1 : -1;
+		case WAVE_PULSE25:
+			return (p < 0.25f) ? 1 : -1;
+		case WAVE_PULSE12:
+			return (p < 0.125f) ? 1 : -1;
+		case WAVE_SAW_UP:
+			return 2 * p - 1;
+		case WAVE_SAW_DOWN:
+			return 1 - 2 * p;
+		}
+		return 0;
+	}
+
+	// each table ends with a copy of its first value for interpolation
+	static struct wave_init_t
+	{
+		wave_init_t()
+		{
+			for (int w = 0; w < WAVE_COUNT; ++w)
+			{
+				float* table = waves + w * (LfoBank::TABLE_SIZE + 1);
+				for (int i = 0; i < LfoBank::TABLE_SIZE; ++i)
+					table[i] = wave_value(w, float(i) / LfoBank::TABLE_SIZE);
+				table[LfoBank::TABLE_SIZE] = table[0];
+			}
+		}
+	} wave_init;
+
+	/////////////////////////////////////////////////////////////
+	// class LfoBank
+
+	LfoBank::LfoBank(int capacity, int subdivisions) :
+		_capacity(0),
+		_stride(0),
+		_subdivisions(subdivisions),
+		_period(0)
+	{
+#if defined(LIBSFZ_HAVE_AVX2)
+		if (simd::HasAVX2())
+			_process = kernels::avx2_lfo();
+		else
+#endif
+			_process = &kernels::process_lfo<simd::native_t>;
+
+		SetRate(44100, 64);
+		Resize(capacity);
+	}
+
+	LfoBank::~LfoBank()
+	{
+	}
+
+	void
+	LfoBank::Resize(int capacity)
+	{
+		// whole vectors of the widest instruction set
+		_capacity = capacity;
+		_stride = (capacity + 7) & ~7;
+
+		_phase.assign(_stride, 0.0f);
+		_rate.assign(_stride, 0.0f);
+		_offset.assign(_stride, 0.0f);
+		_age.assign(_stride, 0.0f);
+		_delay.assign(_stride, 0.0f);
+		_fade.assign(_stride, 1.0f);
+		_ramp.assign(_stride * _subdivisions, 0.0f);
+	}
+
+	void
+	LfoBank::SetRate(float sample_rate, int block_size)
+	{
+		_period = float(block_size) / _subdivisions / sample_rate;
+	}
+
+	void
+	LfoBank::Start(int slot, lfo_wave_t wave, float freq, float delay, float fade, float phase)
+	{
+		if (wave < 0 || wave >= WAVE_COUNT)
+			wave = WAVE_TRIANGLE;
+
+		_phase[slot] = phase - std::floor(phase);
+		_rate[slot] = (freq > 0) ? freq * _period : 0;
+		_offset[slot] = float(wave * (TABLE_SIZE + 1));
+		_age[slot] = 0;
+		_delay[slot] = (delay > 0) ? delay / _period : 0;
+		_fade[slot] = (fade > 0) ? _period / fade : 1e9f;
+		for (int k = 0; k < _subdivisions; ++k)
+			_ramp[k * _stride + slot] = 0;
+	}
+
+	void
+	LfoBank::Process(int count, float fraction)
+	{
+		if (count <= 0)
+			return;
+
+		state_t state;
+		state.phase = &_phase[0];
+		state.rate = &_rate[0];
+		state.offset = &_offset[0];
+		state.age = &_age[0];
+		state.delay = &_delay[0];
+		state.fade = &_fade[0];
+		state.ramp = &_ramp[0];
+		state.step = fraction;
+		state.stride = _stride;
+		state.subdivisions = _subdivisions;
+
+		_process(state, (count + 7) & ~7);
+	}
+
+	float
+	LfoBank::GetMean(int slot) const
+	{
+		float sum = 0;
+		for (int k = 0; k < _subdivisions; ++k)
+			sum += _ramp[k * _stride + slot];
+		return sum / _subdivisions;
+	}
+
+	const float*
+	LfoBank::Table()
+	{
+		return waves;
+	}
+
+} // !namespace sfz
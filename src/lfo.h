@@ -0,0 +1,115 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_LFO_H
+#define LIBSFZ_LFO_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <vector>
+
+namespace sfz
+{
+
+	// Enumerations, numbered like lfoN_wave
+	enum lfo_wave_t { WAVE_TRIANGLE, WAVE_SINE, WAVE_PULSE75, WAVE_SQUARE,
+			  WAVE_PULSE25, WAVE_PULSE12, WAVE_SAW_UP, WAVE_SAW_DOWN,
+			  WAVE_COUNT };
+
+	/////////////////////////////////////////////////////////////
+	// class LfoBank
+
+	/// Low frequency oscillators of many voices evaluated side by side
+	///
+	/// Like the Smoother, every slot (an LFO of a voice) is advanced
+	/// once per block and its value at the end of each sub-block is
+	/// written to the ramp. Shapes are read from one wavetable per
+	/// lfo_wave_t with linear interpolation. Delay and fade-in are
+	/// counted in sub-blocks. State is kept as one array per field and
+	/// processed SIMD-wide across slots, with an AVX2 kernel selected
+	/// at runtime.
+	class LfoBank
+	{
+	public:
+		enum { TABLE_SIZE = 256 };
+
+		LfoBank(int capacity = 0, int subdivisions = 4);
+		virtual ~LfoBank();
+
+		/// Allocate storage for capacity slots, not real-time safe
+		void Resize(int capacity);
+
+		/// Set the sample rate and the number of frames per block
+		void SetRate(float sample_rate, int block_size);
+
+		/// Restart slot, times in seconds, phase 0-1
+		void Start(int slot, lfo_wave_t wave, float freq, float delay, float fade, float phase);
+
+		/// Change the frequency (Hz) of slot, negative frequencies stop it
+		void SetFrequency(int slot, float freq) { _rate[slot] = (freq > 0) ? freq * _period : 0; }
+
+		/// Advance the slots [0, count) by one block, or the fraction of
+		/// one for a short block
+		void Process(int count, float fraction = 1.0f);
+
+		/// Value (-1..1) of slot at the end of sub-block k of the last block
+		float Get(int k, int slot) const { return _ramp[k * _stride + slot]; }
+
+		/// Value of slot averaged over the sub-blocks of the last block
+		float GetMean(int slot) const;
+
+		int Subdivisions() const { return _subdivisions; }
+
+		/// Arrays processed by the kernels, one value per slot
+		struct state_t
+		{
+			float* phase;   // 0-1
+			float* rate;    // cycles per sub-block
+			float* offset;  // wavetable start
+			float* age;     // sub-blocks since start
+			float* delay;   // sub-blocks
+			float* fade;    // 1 / fade-in sub-blocks
+			float* ramp;    // [sub-block][slot]
+			float step;     // sub-blocks per sub-block of this block
+			int stride;
+			int subdivisions;
+		};
+
+		typedef void (*process_fn)(const state_t& state, int count);
+
+		/// The wavetables, WAVE_COUNT tables of TABLE_SIZE + 1 values
+		static const float* Table();
+
+	private:
+		int _capacity;
+		int _stride;
+		int _subdivisions;
+		float _period;          // seconds per sub-block
+		std::vector<float> _phase;
+		std::vector<float> _rate;
+		std::vector<float> _offset;
+		std::vector<float> _age;
+		std::vector<float> _delay;
+		std::vector<float> _fade;
+		std::vector<float> _ramp;
+		process_fn _process;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_LFO_H
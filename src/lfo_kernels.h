@@ -0,0 +1,94 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_LFO_KERNELS_H
+#define LIBSFZ_LFO_KERNELS_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Oscillator kernels shared by the per instruction set translation
+// units. Not part of the public interface.
+
+#include "lfo.h"
+#include "simd.h"
+
+namespace sfz
+{
+namespace kernels
+{
+
+#if defined(LIBSFZ_HAVE_AVX2)
+	/// LFO kernel compiled for AVX2, defined in lfo_avx2.cpp
+	LfoBank::process_fn avx2_lfo();
+#endif
+
+	// one copy per translation unit, see simd.h
+	namespace
+	{
+
+	template<class S>
+	void
+	process_lfo(const LfoBank::state_t& state, int count)
+	{
+		typedef typename S::V V;
+		const float* table = LfoBank::Table();
+		const V zero = S::set1(0.0f);
+		const V step = S::set1(state.step);
+		const V size = S::set1(float(LfoBank::TABLE_SIZE));
+
+		for (int j = 0; j < count; j += S::width)
+		{
+			V phase = S::loadu(state.phase + j);
+			V age = S::loadu(state.age + j);
+			const V rate = S::loadu(state.rate + j);
+			const V offset = S::loadu(state.offset + j);
+			const V delay = S::loadu(state.delay + j);
+			const V fade = S::loadu(state.fade + j);
+
+			for (int k = 0; k < state.subdivisions; ++k)
+			{
+				age = S::add(age, step);
+
+				// the phase only runs once the delay is over, the
+				// first sub-block after it partially
+				V running = S::sub(age, delay);
+				V active = S::min(S::max(running, zero), step);
+				phase = S::madd(rate, active, phase);
+				phase = S::sub(phase, S::to_float(S::trunc(phase)));
+
+				V level = S::min(S::max(S::mul(running, fade), zero), S::set1(1.0f));
+
+				V pos = S::madd(phase, size, offset);
+				typename S::I i = S::trunc(pos);
+				V f = S::sub(pos, S::to_float(i));
+				V a = S::gather(table, i);
+				V b = S::gather(table + 1, i);
+				S::storeu(state.ramp + k * state.stride + j, S::mul(S::madd(S::sub(b, a), f, a), level));
+			}
+
+			S::storeu(state.phase + j, phase);
+			S::storeu(state.age + j, age);
+		}
+	}
+
+	} // !namespace
+
+} // !namespace kernels
+} // !namespace sfz
+
+#endif // !LIBSFZ_LFO_KERNELS_H
@@ -0,0 +1,180 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "modmatrix.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace sfz
+{
+
+	// shape tables, filled once at static initialization
+	static float shapes[CURVE_COUNT][128];
+
+	static struct shape_init_t
+	{
+		shape_init_t()
+		{
+			for (int i = 0; i < 128; ++i)
+			{
+				float x = i / 127.0f;
+				shapes[CURVE_LINEAR][i]  = x;
+				shapes[CURVE_CONVEX][i]  = x * x;
+				shapes[CURVE_CONCAVE][i] = std::sqrt(x);
+			}
+		}
+	} shape_init;
+
+	/////////////////////////////////////////////////////////////
+	// class ControlState
+
+	ControlState::ControlState()
+	{
+		std::memset(cc, 0, sizeof(cc));
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class ModMatrix
+
+	ModMatrix::ModMatrix() :
+		targets(0)
+	{
+	}
+
+	ModMatrix::ModMatrix(const Region* region) :
+		targets(0)
+	{
+		Compile(region);
+	}
+
+	ModMatrix::~ModMatrix()
+	{
+	}
+
+	void
+	ModMatrix::Compile(const Region* region)
+	{
+		rows.clear();
+		sources.reset();
+		targets = 0;
+
+		for (int i = 0; i < 128; ++i)
+		{
+			// amplifier
+			add(i, MOD_GAIN, region->gain_oncc[i]);
+			add(i, MOD_PAN, region->pan_oncc[i]);
+			add(i, MOD_WIDTH, region->width_oncc[i]);
+			add(i, MOD_POSITION, region->position_oncc[i]);
+
+			// filter
+			add(i, MOD_CUTOFF, region->cutoff_oncc[i], region->cutoff_curvecc[i],
+			    region->cutoff_smoothcc[i], region->cutoff_stepcc[i]);
+			add(i, MOD_RESONANCE, region->resonance_oncc[i], region->resonance_curvecc[i],
+			    region->resonance_smoothcc[i], region->resonance_stepcc[i]);
+			add(i, MOD_CUTOFF2, region->cutoff2_oncc[i], region->cutoff2_curvecc[i],
+			    region->cutoff2_smoothcc[i], region->cutoff2_stepcc[i]);
+			add(i, MOD_RESONANCE2, region->resonance2_oncc[i], region->resonance2_curvecc[i],
+			    region->resonance2_smoothcc[i], region->resonance2_stepcc[i]);
+
+			// per voice equalizer
+			add(i, MOD_EQ1_FREQ, region->eq1_freq_oncc[i]);
+			add(i, MOD_EQ2_FREQ, region->eq2_freq_oncc[i]);
+			add(i, MOD_EQ3_FREQ, region->eq3_freq_oncc[i]);
+			add(i, MOD_EQ1_BW, region->eq1_bw_oncc[i]);
+			add(i, MOD_EQ2_BW, region->eq2_bw_oncc[i]);
+			add(i, MOD_EQ3_BW, region->eq3_bw_oncc[i]);
+			add(i, MOD_EQ1_GAIN, region->eq1_gain_oncc[i]);
+			add(i, MOD_EQ2_GAIN, region->eq2_gain_oncc[i]);
+			add(i, MOD_EQ3_GAIN, region->eq3_gain_oncc[i]);
+
+			// sample player
+			if (region->delay_oncc[i])
+				add(i, MOD_DELAY, *region->delay_oncc[i]);
+			if (region->delay_samples_oncc[i])
+				add(i, MOD_DELAY_SAMPLES, *region->delay_samples_oncc[i]);
+			if (region->offset_oncc[i])
+				add(i, MOD_SAMPLE_OFFSET, *region->offset_oncc[i]);
+
+			// lfos
+			add(i, MOD_AMPLFO_DEPTH, region->amplfo_depthcc[i]);
+			add(i, MOD_AMPLFO_FREQ, region->amplfo_freqcc[i]);
+			add(i, MOD_FILLFO_DEPTH, region->fillfo_depthcc[i]);
+			add(i, MOD_FILLFO_FREQ, region->fillfo_freqcc[i]);
+			add(i, MOD_PITCHLFO_DEPTH, region->pitchlfo_depthcc[i]);
+			add(i, MOD_PITCHLFO_FREQ, region->pitchlfo_freqcc[i]);
+		}
+	}
+
+	void
+	ModMatrix::add(int cc, mod_target_t target, float depth, int curve, float smooth, float step)
+	{
+		if (depth == 0)
+			return;
+
+		row_t row;
+		row.cc = cc;
+		row.target = target;
+		row.curve = (curve >= 0 && curve < CURVE_COUNT) ? curve : CURVE_LINEAR;
+		row.depth = depth;
+		row.smooth = smooth;
+		row.step = step;
+		rows.push_back(row);
+
+		sources.set(cc);
+		targets |= 1u << target;
+	}
+
+	void
+	ModMatrix::Evaluate(const uint8_t* cc, float* values) const
+	{
+		for (int t = 0; t < MOD_TARGET_COUNT; ++t)
+			if (targets & (1u << t))
+				values[t] = 0;
+
+		for (std::vector<row_t>::const_iterator it = rows.begin(); it != rows.end(); ++it)
+		{
+			float value = it->depth * shapes[it->curve][cc[it->cc]];
+			if (it->step > 0)
+				value = std::floor(value / it->step + 0.5f) * it->step;
+			values[it->target] += value;
+		}
+	}
+
+	float
+	ModMatrix::GetSmooth(mod_target_t target) const
+	{
+		float smooth = 0;
+		for (std::vector<row_t>::const_iterator it = rows.begin(); it != rows.end(); ++it)
+			if (it->target == target && it->smooth > smooth)
+				smooth = it->smooth;
+		return smooth;
+	}
+
+	float
+	ModMatrix::Shape(int curve, uint8_t val)
+	{
+		if (curve < 0 || curve >= CURVE_COUNT)
+			curve = CURVE_LINEAR;
+		return shapes[curve][val & 127];
+	}
+
+} // !namespace sfz
@@ -0,0 +1,139 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_MODMATRIX_H
+#define LIBSFZ_MODMATRIX_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <bitset>
+#include <vector>
+
+#include "sfz.h"
+
+namespace sfz
+{
+
+	// Modulation targets of the *_onccN opcodes, in target units
+	enum mod_target_t { MOD_GAIN,                                   // dB
+			    MOD_PAN, MOD_WIDTH, MOD_POSITION,           // %
+			    MOD_CUTOFF, MOD_RESONANCE,                  // cents, dB
+			    MOD_CUTOFF2, MOD_RESONANCE2,                // cents, dB
+			    MOD_EQ1_FREQ, MOD_EQ2_FREQ, MOD_EQ3_FREQ,   // Hz
+			    MOD_EQ1_BW, MOD_EQ2_BW, MOD_EQ3_BW,         // octaves
+			    MOD_EQ1_GAIN, MOD_EQ2_GAIN, MOD_EQ3_GAIN,   // dB
+			    MOD_DELAY,                                  // seconds
+			    MOD_DELAY_SAMPLES, MOD_SAMPLE_OFFSET,       // frames
+			    MOD_AMPLFO_DEPTH, MOD_AMPLFO_FREQ,          // dB, Hz
+			    MOD_FILLFO_DEPTH, MOD_FILLFO_FREQ,          // cents, Hz
+			    MOD_PITCHLFO_DEPTH, MOD_PITCHLFO_FREQ,      // cents, Hz
+			    MOD_TARGET_COUNT };
+
+	// Shapes selectable by *_curveccN
+	enum mod_curve_t { CURVE_LINEAR, CURVE_CONVEX, CURVE_CONCAVE, CURVE_COUNT };
+
+	typedef std::bitset<128> ccmask_t;
+
+	/////////////////////////////////////////////////////////////
+	// class ControlState
+
+	/// CC values of a channel and the set changed since the last block
+	class ControlState
+	{
+	public:
+		ControlState();
+
+		/// Set controller cont to val, marking it changed
+		void Set(uint8_t cont, uint8_t val)
+		{
+			if (cc[cont] == val) return;
+			cc[cont] = val;
+			changed.set(cont);
+		}
+
+		/// Forget the changes once every voice has seen the block
+		void EndBlock() { changed.reset(); }
+
+		uint8_t cc[128];
+		ccmask_t changed;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class ModMatrix
+
+	/// Sparse CC modulation matrix compiled from the *_onccN opcodes of a Region
+	///
+	/// Only non-zero connections become rows, so evaluation cost is
+	/// proportional to the connections an instrument actually uses.
+	class ModMatrix
+	{
+	public:
+		ModMatrix();
+		ModMatrix(const Region* region);
+		virtual ~ModMatrix();
+
+		/// Collect the non-zero connections of region
+		void Compile(const Region* region);
+
+		/// Compute all modulated targets from the CC values
+		void Evaluate(const uint8_t* cc, float* values) const;
+
+		/// Re-evaluate only if a source CC changed, return true if it did
+		bool Update(const ControlState& state, float* values) const
+		{
+			if (!DependsOn(state.changed))
+				return false;
+			Evaluate(state.cc, values);
+			return true;
+		}
+
+		/// Return true if any of the changed CCs is a source of the matrix
+		bool DependsOn(const ccmask_t& changed) const { return (sources & changed).any(); }
+
+		/// Return true if target has at least one connection
+		bool HasTarget(mod_target_t target) const { return (targets & (1u << target)) != 0; }
+
+		/// Return the longest smoothing time in ms of the connections to target
+		float GetSmooth(mod_target_t target) const;
+
+		/// Return the shaped 0..1 value of curve for a CC value
+		static float Shape(int curve, uint8_t val);
+
+		/// A single source CC to target connection
+		struct row_t
+		{
+			uint8_t cc;
+			uint8_t target;
+			uint8_t curve;
+			float depth;
+			float smooth;
+			float step;
+		};
+
+		std::vector<row_t> rows;
+		ccmask_t sources;
+		unsigned targets;
+
+	private:
+		void add(int cc, mod_target_t target, float depth, int curve = CURVE_LINEAR,
+			 float smooth = 0, float step = 0);
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_MODMATRIX_H
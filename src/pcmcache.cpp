@@ -0,0 +1,260 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "pcmcache.h"
+#include "samplestore.h"
+
+namespace sfz
+{
+
+	namespace ipc = boost::interprocess;
+
+	// first page of a cache file, the key follows and the frames start
+	// on the next page
+	struct file_header_t
+	{
+		char magic[8];
+		boost::int32_t channels;
+		boost::int32_t format;
+		boost::int64_t frames;
+		boost::int64_t preloaded;
+		boost::int64_t loop_start;
+		boost::int64_t loop_end;
+		float rate;
+		boost::uint32_t key_length;
+	};
+
+	static const char MAGIC[8] = { 'l', 'i', 'b', 's', 'f', 'z', 'C', '2' };
+
+	// the mapping of a cache file, handed to the Sample as its owner
+	struct file_mapping_t
+	{
+		ipc::mapped_region region;
+	};
+
+	// what a file holds: the source by path, size and modification time,
+	// the frames and the format, empty if the source cannot be found
+	static std::string
+	file_key(const std::string& path, long preloaded, sample_format_t format)
+	{
+		struct stat st;
+		if (::stat(path.c_str(), &st))
+			return std::string();
+		std::ostringstream key;
+		key << SampleStore::Resolve(path) << '\n'
+		    << st.st_size << ':' << st.st_mtime << '\n'
+		    << preloaded << ':' << int(format);
+		return key.str();
+	}
+
+	// file of key in directory, named by a 64 bit FNV-1a hash
+	static std::string
+	file_name(const std::string& directory, const std::string& key)
+	{
+		boost::uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < key.size(); ++i)
+			hash = (hash ^ (unsigned char) key[i]) * 1099511628211ULL;
+		char name[32];
+		std::sprintf(name, "%016llx.pcm", (unsigned long long) hash);
+		return directory + "/" + name;
+	}
+
+	// a file of the cache directory, by the time it was last used
+	struct cached_t
+	{
+		time_t used;
+		off_t size;
+		std::string name;
+
+		bool operator <(const cached_t& other) const { return used < other.used; }
+	};
+
+	// drop the least recently used files of directory until the rest fit
+	// in limit bytes, along with the temporary files of decodes that
+	// died an hour ago or more; processes mapping a removed file keep
+	// reading it
+	static void
+	trim(const std::string& directory, double limit, const std::string& keep)
+	{
+		DIR* dir = ::opendir(directory.c_str());
+		if (!dir)
+			return;
+		std::vector<cached_t> files;
+		double total = 0;
+		time_t stale = std::time(0) - 3600;
+		while (struct dirent* entry = ::readdir(dir))
+		{
+			std::string name = entry->d_name;
+			bool temp = name.find(".pcm.") != std::string::npos;
+			if (!temp && (name.size() < 4 || name.compare(name.size() - 4, 4, ".pcm")))
+				continue;
+			name = directory + "/" + name;
+			struct stat st;
+			if (::stat(name.c_str(), &st) || !S_ISREG(st.st_mode))
+				continue;
+			if (temp)
+			{
+				if (st.st_mtime < stale)
+					std::remove(name.c_str());
+				continue;
+			}
+			cached_t file = { st.st_mtime, st.st_size, name };
+			files.push_back(file);
+			total += st.st_size;
+		}
+		::closedir(dir);
+
+		std::sort(files.begin(), files.end());
+		for (size_t i = 0; i < files.size() && total > limit; ++i)
+		{
+			if (files[i].name != keep && !std::remove(files[i].name.c_str()))
+				total -= files[i].size;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class PcmCache
+
+	Sample*
+	PcmCache::Map(const std::string& directory, const std::string& path, WavFile& wav,
+		      long preloaded, sample_format_t format, double limit, double* bytes)
+	{
+		long held = (preloaded >= 0 && preloaded < wav.Frames()) ? preloaded : wav.Frames();
+		std::string key = file_key(path, held, format);
+		size_t page = ipc::mapped_region::get_page_size();
+		if (key.empty() || sizeof(file_header_t) + key.size() > page)
+			return 0;
+
+		std::string name = file_name(directory, key);
+		size_t size = Sample::Layout(wav.Channels(), wav.Frames(), held, format);
+
+		// a complete file of the right size and key is mapped as it is
+		struct stat st;
+		if (!::stat(name.c_str(), &st) && st.st_size == off_t(page + size))
+		{
+			try
+			{
+				ipc::file_mapping file(name.c_str(), ipc::read_only);
+				boost::shared_ptr<file_mapping_t> mapping(new file_mapping_t());
+				ipc::mapped_region region(file, ipc::read_only, 0, page + size);
+				mapping->region.swap(region);
+
+				const unsigned char* base = (const unsigned char*) mapping->region.get_address();
+				const file_header_t* header = (const file_header_t*) base;
+				if (!std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) &&
+				    header->key_length == key.size() && !std::memcmp(header + 1, key.data(), key.size()))
+				{
+					Sample* sample = new Sample();
+					sample->Place(header->channels, header->frames, header->rate, header->preloaded,
+						      sample_format_t(header->format), (unsigned char*) base + page, mapping);
+					sample->loop_start = header->loop_start;
+					sample->loop_end = header->loop_end;
+					// the modification time tells trim() it was used
+					if (limit > 0)
+						::utimes(name.c_str(), 0);
+					return sample;
+				}
+			}
+			catch (ipc::interprocess_exception&)
+			{
+			}
+		}
+
+		// otherwise the source is decoded into a file of its own, unique
+		// even among the threads of this process, that only gets its
+		// name once it is complete
+		std::vector<char> pattern(name.begin(), name.end());
+		const char suffix[] = ".XXXXXX";
+		pattern.insert(pattern.end(), suffix, suffix + sizeof(suffix));
+		int out = ::mkstemp(&pattern[0]);
+		if (out < 0)
+			return 0;
+		std::string temp(&pattern[0]);
+		bool sized = !::fchmod(out, 0644) && !::ftruncate(out, page + size);
+		::close(out);
+		if (!sized)
+		{
+			std::remove(temp.c_str());
+			return 0;
+		}
+
+		Sample* sample = new Sample();
+		try
+		{
+			ipc::file_mapping file(temp.c_str(), ipc::read_write);
+			boost::shared_ptr<file_mapping_t> mapping(new file_mapping_t());
+			ipc::mapped_region region(file, ipc::read_write, 0, page + size);
+			mapping->region.swap(region);
+
+			unsigned char* base = (unsigned char*) mapping->region.get_address();
+			file_header_t* header = (file_header_t*) base;
+			std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+			header->channels = wav.Channels();
+			header->format = format;
+			header->frames = wav.Frames();
+			header->preloaded = held;
+			header->loop_start = wav.LoopStart();
+			header->loop_end = wav.LoopEnd();
+			header->rate = wav.Rate();
+			header->key_length = key.size();
+			std::memcpy(header + 1, key.data(), key.size());
+
+			sample->Place(wav.Channels(), wav.Frames(), wav.Rate(), held, format, base + page, mapping);
+			long read = wav.Read(sample);
+			if (bytes)
+				*bytes += double(read) * wav.FrameSize();
+			if (read == held)
+			{
+				// the audio is good even if the file cannot be kept
+				if (!mapping->region.flush() || std::rename(temp.c_str(), name.c_str()))
+					std::remove(temp.c_str());
+				else if (limit > 0)
+					trim(directory, limit, name);
+				return sample;
+			}
+		}
+		catch (ipc::interprocess_exception&)
+		{
+		}
+
+		std::remove(temp.c_str());
+		delete sample;
+		return 0;
+	}
+
+} // !namespace sfz
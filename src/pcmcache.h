@@ -0,0 +1,69 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_PCMCACHE_H
+#define LIBSFZ_PCMCACHE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <string>
+
+#include "sample.h"
+#include "wav.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class PcmCache
+
+	/// Decoded audio kept in files of a cache directory across runs
+	///
+	/// A file holds the frames of one sample in the memory layout of
+	/// Sample, after a header page naming the resolved path, size and
+	/// modification time of the source together with the format and
+	/// the frames held. Files are mapped read-only, so a warm start
+	/// decodes nothing and only the pages actually played are read;
+	/// processes mapping the same file share its pages.
+	///
+	/// With a limit, writing a file evicts the least recently mapped
+	/// ones until the directory fits, along with temporary files left
+	/// by decodes that died; without one the host manages the
+	/// directory.
+	class PcmCache
+	{
+	public:
+		/// Audio of the first preloaded frames (all if negative) of
+		/// path in format from its file in directory, the open wav is
+		/// decoded into a new file if there is none yet
+		///
+		/// Returns NULL when the cache cannot be used, the caller then
+		/// decodes as usual. The directory is kept within limit bytes,
+		/// no limit if 0. The bytes read from the source are added to
+		/// bytes if given.
+		static Sample* Map(const std::string& directory, const std::string& path, WavFile& wav,
+				   long preloaded, sample_format_t format, double limit = 0, double* bytes = 0);
+
+	private:
+		PcmCache();
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_PCMCACHE_H
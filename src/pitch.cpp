@@ -0,0 +1,44 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "pitch.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class PitchTable
+
+	PitchTable::PitchTable()
+	{
+		for (int i = 0; i <= 2 * MAX_OCTAVES; ++i)
+			_octave[i] = std::ldexp(1.0, i - MAX_OCTAVES);
+		for (int i = 0; i < COARSE_STEPS; ++i)
+			_coarse[i] = std::pow(2.0, double(i * FINE_STEPS) / OCTAVE);
+		for (int i = 0; i < FINE_STEPS; ++i)
+			_fine[i] = std::pow(2.0, double(i) / OCTAVE);
+	}
+
+	PitchTable::~PitchTable()
+	{
+	}
+
+} // !namespace sfz
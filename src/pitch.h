@@ -0,0 +1,77 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_PITCH_H
+#define LIBSFZ_PITCH_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <cmath>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class PitchTable
+
+	/// Cents to frequency ratio without calling pow or exp2
+	///
+	/// Pitch is kept as an integer count of steps of 1/STEPS_PER_CENT
+	/// cent. A step count splits into whole octaves, a coarse table of
+	/// the COARSE_STEPS points of an octave and a fine table of the
+	/// FINE_STEPS steps between two of them, so a ratio is two lookups
+	/// and three multiplications. Rounding to a step is at most 1/32
+	/// cent, well under the 2-3 cents the ear can tell apart.
+	class PitchTable
+	{
+	public:
+		enum { STEPS_PER_CENT = 16, OCTAVE = 1200 * STEPS_PER_CENT };
+		enum { FINE_BITS = 6, FINE_STEPS = 1 << FINE_BITS, FINE_MASK = FINE_STEPS - 1 };
+		enum { COARSE_STEPS = OCTAVE / FINE_STEPS, MAX_OCTAVES = 16 };
+
+		PitchTable();
+		virtual ~PitchTable();
+
+		/// Nearest step count of cents
+		static int ToSteps(float cents) { return int(std::floor(cents * STEPS_PER_CENT + 0.5f)); }
+
+		/// Frequency ratio of steps, limited to MAX_OCTAVES either way
+		double Ratio(int steps) const
+		{
+			// floor division, the remainder is never negative
+			int octave = (steps >= 0) ? steps / OCTAVE : -((OCTAVE - 1 - steps) / OCTAVE);
+			int rest = steps - octave * OCTAVE;
+			if (octave < -MAX_OCTAVES)
+				octave = -MAX_OCTAVES;
+			else if (octave > MAX_OCTAVES)
+				octave = MAX_OCTAVES;
+			return _octave[octave + MAX_OCTAVES] * _coarse[rest >> FINE_BITS] * _fine[rest & FINE_MASK];
+		}
+
+		/// Frequency ratio of cents rounded to a step
+		double Ratio(float cents) const { return Ratio(ToSteps(cents)); }
+
+	private:
+		double _octave[2 * MAX_OCTAVES + 1];
+		double _coarse[COARSE_STEPS];
+		double _fine[FINE_STEPS];
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_PITCH_H
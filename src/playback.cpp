@@ -0,0 +1,396 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "playback.h"
+#include "playback_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// sinc table
+
+	namespace kernels
+	{
+		static float sinc_coefficients[(SINC_PHASES + 1) * 2 * SINC_TAPS];
+
+		// Blackman windowed sinc over the 8 taps at offsets -3..4,
+		// each phase normalized to unity gain at DC
+		static void
+		sinc_row(float frac, float* row)
+		{
+			const double pi = 3.14159265358979323846;
+			double sum = 0;
+			for (int k = 0; k < SINC_TAPS; ++k)
+			{
+				double x = (k - 3) - frac;
+				double s = (std::fabs(x) < 1e-9) ? 1.0 : std::sin(pi * x) / (pi * x);
+				double w = 0.42 + 0.5 * std::cos(pi * x / 4) + 0.08 * std::cos(2 * pi * x / 4);
+				row[k] = float(s * w);
+				sum += s * w;
+			}
+			for (int k = 0; k < SINC_TAPS; ++k)
+				row[k] = float(row[k] / sum);
+		}
+
+		static struct sinc_init_t
+		{
+			sinc_init_t()
+			{
+				float rows[SINC_PHASES + 1][SINC_TAPS];
+				for (int p = 0; p <= SINC_PHASES; ++p)
+					sinc_row(float(p) / SINC_PHASES, rows[p]);
+				for (int p = 0; p < SINC_PHASES; ++p)
+				{
+					float* row = sinc_coefficients + p * 2 * SINC_TAPS;
+					for (int k = 0; k < SINC_TAPS; ++k)
+					{
+						row[k] = rows[p][k];
+						row[SINC_TAPS + k] = rows[p + 1][k] - rows[p][k];
+					}
+				}
+			}
+		} sinc_init;
+
+		const float*
+		sinc_table()
+		{
+			return sinc_coefficients;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class Resampler
+
+	Resampler::Resampler(interpolation_t quality)
+	{
+		SetQuality(quality);
+	}
+
+	void
+	Resampler::SetQuality(interpolation_t quality)
+	{
+		_quality = quality;
+		_scalar = kernels::kernel<simd::scalar_t>(quality);
+
+#if defined(LIBSFZ_HAVE_AVX2)
+		if (simd::HasAVX2())
+		{
+			_process = kernels::avx2_kernel(quality);
+			_isa = "avx2";
+		}
+		else
+#endif
+		{
+			_process = kernels::kernel<simd::native_t>(quality);
+#if defined(LIBSFZ_SSE)
+			_isa = "sse2";
+#elif defined(LIBSFZ_NEON)
+			_isa = "neon";
+#else
+			_isa = "scalar";
+#endif
+		}
+
+		switch (quality)
+		{
+		case INTERPOLATION_LINEAR:
+			_before = 0; _after = 1;
+			break;
+		case INTERPOLATION_CUBIC:
+			_before = 1; _after = 2;
+			break;
+		case INTERPOLATION_SINC:
+			_before = 3; _after = 4;
+			break;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class LoopSeam
+
+	LoopSeam::LoopSeam() :
+		_loop_start(0),
+		_loop_end(0),
+		_fade(0)
+	{
+	}
+
+	void
+	LoopSeam::Bake(const Sample* sample, const Region* region)
+	{
+		Clear();
+
+		// the loop as Playback::Start() finds it, the crossfade needs as
+		// many frames before the loop start as it is long
+		long start = region->loop_start ? *region->loop_start : sample->loop_start;
+		long end = region->loop_end ? *region->loop_end + 1 : sample->loop_end + 1;
+		if (region->end && *region->end + 1 < end)
+			end = *region->end + 1;
+		if (start < 0 || end <= start || end > sample->Preloaded())
+			return;
+		long fade = region->loop_crossfade ? long(*region->loop_crossfade * sample->Rate()) : 0;
+		fade = std::max(0L, std::min(fade, std::min(end - start, start)));
+
+		_loop_start = start;
+		_loop_end = end;
+		_fade = fade;
+		long first = Start();
+		long after = Resampler::MAX_AFTER + 1;
+		for (int c = 0; c < sample->Channels(); ++c)
+		{
+			std::vector<float>& data = _data[c];
+			data.resize(end + after - first);
+			for (long i = first; i < end; ++i)
+			{
+				float x = (i < 0) ? 0.0f : sample->Get(c, i);
+				if (i >= end - fade)
+				{
+					// linear, the material around loop points is alike
+					float in = float(i - (end - fade) + 1) / (fade + 1);
+					x = x * (1.0f - in) + sample->Get(c, i - (end - start)) * in;
+				}
+				data[i - first] = x;
+			}
+
+			// the frames after the loop end are its start again
+			for (long i = end; i < end + after; ++i)
+			{
+				long wrapped = start + (i - start) % (end - start);
+				data[i - first] = (wrapped >= first) ? data[wrapped - first] : sample->Get(c, wrapped);
+			}
+		}
+	}
+
+	void
+	LoopSeam::Clear()
+	{
+		_loop_start = _loop_end = _fade = 0;
+		for (int c = 0; c < 2; ++c)
+			std::vector<float>().swap(_data[c]);
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class Playback
+
+	Playback::Playback() :
+		_sample(0),
+		_stream(0),
+		_seam(0),
+		_head(0),
+		_pos(0),
+		_step(1),
+		_end(0),
+		_loop_start(0),
+		_loop_end(0),
+		_loop_mode(NO_LOOP),
+		_released(false),
+		_finished(true)
+	{
+	}
+
+	void
+	Playback::Start(const Sample* sample, const Region* region, long offset, Stream* stream,
+			const LoopSeam* seam)
+	{
+		_sample = sample;
+		_head = sample->Preloaded();
+		_stream = (_head < sample->Frames()) ? stream : 0;
+		_pos = offset;
+		_released = false;
+		_finished = false;
+
+		// end and loop_end are inclusive in SFZ, exclusive here, a
+		// sample without its stream ends with its head
+		_end = _stream ? sample->Frames() : _head;
+		if (region->end && *region->end + 1 < _end)
+			_end = *region->end + 1;
+
+		_loop_start = region->loop_start ? *region->loop_start : sample->loop_start;
+		_loop_end = region->loop_end ? *region->loop_end + 1 : sample->loop_end + 1;
+		if (_loop_end > _end)
+			_loop_end = _end;
+
+		// samples with loop points loop unless told otherwise
+		_loop_mode = region->loop_mode;
+		if (_loop_mode == NO_LOOP && !region->loop_start && sample->loop_start >= 0)
+			_loop_mode = LOOP_CONTINOUS;
+		if ((_loop_mode == LOOP_CONTINOUS || _loop_mode == LOOP_SUSTAIN) &&
+		    (_loop_start < 0 || _loop_end <= _loop_start))
+			_loop_mode = NO_LOOP;
+
+		// a seam baked for other loop points is of no use
+		_seam = seam;
+		if (_loop_mode == NO_LOOP || _loop_mode == ONE_SHOT || !seam || seam->Empty() ||
+		    seam->LoopStart() != _loop_start || seam->LoopEnd() != _loop_end)
+			_seam = 0;
+
+		if (_pos >= _end)
+			_finished = true;
+	}
+
+	int
+	Playback::Render(float* const* out, int frames, const Resampler& resampler)
+	{
+		int channels = Channels();
+		int done = 0;
+		long available = _stream ? _stream->Available() : 0;
+		bool underrun = false;
+
+		while (done < frames && !_finished)
+		{
+			bool loop = looping();
+			double limit = loop ? _loop_end : _end;
+
+			if (_pos >= limit)
+			{
+				if (!loop)
+				{
+					_finished = true;
+					break;
+				}
+				_pos -= _loop_end - _loop_start;
+				continue;
+			}
+
+			// frames whose taps all lie inside [0, limit) and in one
+			// piece of memory, the head, a turn of the ring or the seam
+			long first = long(_pos) - resampler.Before();
+			long origin = 0;
+			double end = (limit < _head) ? limit : _head;
+			bool seam = loop && _seam && first >= _seam->Start();
+			bool streamed = !seam && _stream && first >= _head;
+			if (seam)
+			{
+				origin = _seam->Start();
+				end = limit;
+			}
+			else if (loop && _seam && end > _seam->FadeStart())
+				end = _seam->FadeStart();
+			if (streamed)
+			{
+				origin = _head + ((first - _head) & ~_stream->Mask());
+				end = std::min(std::min(limit, double(origin + _stream->Capacity())),
+					       double(_head + available));
+			}
+
+			// runs of an integer sample end where the decode buffer does
+			bool packed = !streamed && !seam && _sample->Format() != SAMPLE_FLOAT;
+			int most = frames - done;
+			if (packed && 1 + DECODE_FRAMES / _step < most)
+				most = 1 + int(DECODE_FRAMES / _step);
+
+			// the guards of a sample are silent like the frames before
+			// its start and after its end, and the seam goes on with the
+			// loop start, so the taps may reach into them
+			double lead = resampler.Before();
+			double safe = end - resampler.After();
+			if (seam)
+				safe = end;
+			else if (!streamed)
+			{
+				lead = 0;
+				if (!loop && end >= _sample->Frames())
+					safe = end;
+			}
+
+			int n = 0;
+			if (_pos >= origin + lead && _pos < safe)
+			{
+				double run = std::ceil((safe - _pos) / _step);
+				n = (run < most) ? int(run) : most;
+			}
+
+			if (n > 0)
+			{
+				for (int c = 0; c < channels; ++c)
+				{
+					if (packed)
+					{
+						// one frame more than the taps in case the
+						// run positions round up
+						long from = long(_pos) - resampler.Before();
+						long to = long(_pos + (n - 1) * _step) + resampler.After() + 2;
+						_sample->Decode(c, from, to - from, _decoded);
+						resampler.Process(_decoded, _pos - from, _step, out[c] + done, n);
+						continue;
+					}
+					const float* data = seam ? _seam->Data(c) : streamed ? _stream->Data(c) : _sample->Data(c);
+					resampler.Process(data, _pos - origin, _step, out[c] + done, n);
+				}
+				_pos += n * _step;
+				done += n;
+			}
+			else
+			{
+				for (int c = 0; c < channels; ++c)
+					out[c][done] = edge(c, resampler, available);
+				underrun = underrun || (_stream && _head + available < _end &&
+							 _pos + resampler.After() >= _head + available);
+				_pos += _step;
+				++done;
+			}
+		}
+
+		// hand the frames behind the play head back to the I/O thread
+		if (_stream)
+		{
+			_stream->Consume(long(_pos) - resampler.Before() - _head);
+			if (underrun && !_finished)
+				_stream->Underrun();
+		}
+
+		return done;
+	}
+
+	float
+	Playback::edge(int channel, const Resampler& resampler, long available) const
+	{
+		float taps[Resampler::MAX_BEFORE + Resampler::MAX_AFTER + 1];
+		const float* ring = _stream ? _stream->Data(channel) : 0;
+		long base = (long) std::floor(_pos);
+		bool loop = looping();
+		long loop_length = _loop_end - _loop_start;
+
+		for (int k = -resampler.Before(); k <= resampler.After(); ++k)
+		{
+			long i = base + k;
+			if (loop && i >= _loop_end)
+				i = _loop_start + (i - _loop_start) % loop_length;
+			if (i < 0 || i >= _end)
+				taps[Resampler::MAX_BEFORE + k] = 0.0f;
+			else if (loop && _seam && i >= _seam->Start() && i < _loop_end)
+				taps[Resampler::MAX_BEFORE + k] = _seam->Data(channel)[i - _seam->Start()];
+			else if (i < _head)
+				taps[Resampler::MAX_BEFORE + k] = _sample->Get(channel, i);
+			else
+				taps[Resampler::MAX_BEFORE + k] =
+					(i - _head < available) ? ring[(i - _head) & _stream->Mask()] : 0.0f;
+		}
+
+		return resampler.Interpolate(taps + Resampler::MAX_BEFORE, float(_pos - base));
+	}
+
+} // !namespace sfz
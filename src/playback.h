@@ -0,0 +1,210 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_PLAYBACK_H
+#define LIBSFZ_PLAYBACK_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <vector>
+
+#include "sfz.h"
+#include "sample.h"
+#include "stream.h"
+
+namespace sfz
+{
+
+	// Enumerations
+	enum interpolation_t { INTERPOLATION_LINEAR, INTERPOLATION_CUBIC, INTERPOLATION_SINC };
+
+	/// Resample frames of one channel starting at pos, advancing by step
+	typedef void (*resample_fn)(const float* data, double pos, double step, float* out, int frames);
+
+	/////////////////////////////////////////////////////////////
+	// class Resampler
+
+	/// Interpolating sample reader of a selectable quality
+	///
+	/// The kernel for the best instruction set available (AVX2, SSE2
+	/// or NEON) is picked once when the quality is set. Kernels read
+	/// Before() frames before and After() frames after the integer
+	/// part of each position without any bounds checks.
+	class Resampler
+	{
+	public:
+		Resampler(interpolation_t quality = INTERPOLATION_CUBIC);
+
+		void SetQuality(interpolation_t quality);
+		interpolation_t Quality() const { return _quality; }
+
+		/// Resample frames using the vectorized kernel
+		void Process(const float* data, double pos, double step, float* out, int frames) const
+		{
+			_process(data, pos, step, out, frames);
+		}
+
+		/// Interpolate a single frame from taps[-Before()..After()]
+		float Interpolate(const float* taps, float frac) const
+		{
+			float out;
+			_scalar(taps, frac, 0, &out, 1);
+			return out;
+		}
+
+		int Before() const { return _before; }
+		int After() const { return _after; }
+
+		/// Name of the instruction set in use
+		const char* Isa() const { return _isa; }
+
+		/// Widest margin of any quality
+		enum { MAX_BEFORE = 3, MAX_AFTER = 4 };
+
+	private:
+		interpolation_t _quality;
+		resample_fn _process;
+		resample_fn _scalar;
+		int _before;
+		int _after;
+		const char* _isa;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class LoopSeam
+
+	/// The end of a loop joined to its start, baked once so that a
+	/// looping voice reads across the loop end like any other frames
+	///
+	/// The loop_crossfade seconds before the loop end fade out while
+	/// the same stretch before the loop start fades in, so the jump
+	/// back to the loop start continues the audio it faded into. The
+	/// seam holds those frames plus enough unchanged frames before them
+	/// and loop start frames after the loop end for the widest
+	/// resampler, all in one piece; without a crossfade only the
+	/// latter two are left.
+	class LoopSeam
+	{
+	public:
+		LoopSeam();
+
+		/// Bake the seam of the loop of region in sample, the seam stays
+		/// empty if there is no loop or it is not in memory
+		void Bake(const Sample* sample, const Region* region);
+
+		/// Forget the seam
+		void Clear();
+
+		bool Empty() const { return _loop_end == 0; }
+
+		/// Loop points the seam was baked for, end exclusive
+		long LoopStart() const { return _loop_start; }
+		long LoopEnd() const { return _loop_end; }
+
+		/// First frame held by the seam and first frame of the crossfade
+		long Start() const { return _loop_end - _fade - Resampler::MAX_BEFORE - Resampler::MAX_AFTER; }
+		long FadeStart() const { return _loop_end - _fade; }
+
+		/// Frames of channel from Start() on
+		const float* Data(int channel) const { return &_data[channel][0]; }
+
+	private:
+		long _loop_start;
+		long _loop_end;
+		long _fade;
+		std::vector<float> _data[2];
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class Playback
+
+	/// Play head of a voice reading through a Sample
+	///
+	/// Render() finds how many frames can be produced before the next
+	/// boundary (loop end, sample end, start of the data) and hands
+	/// that whole run to the resampler, so the kernels never check
+	/// bounds. Only the few frames whose taps straddle a boundary go
+	/// through the scalar path, which wraps or zero-pads the taps.
+	///
+	/// The frames of a streamed sample after its preloaded head are
+	/// read from the Stream, where the end of the ring and the frames
+	/// not yet read from disk are boundaries like any other. So is the
+	/// start of a LoopSeam while looping.
+	///
+	/// Integer samples are decoded into a small buffer just before the
+	/// resampler reads them, runs are cut so that their taps fit.
+	class Playback
+	{
+	public:
+		Playback();
+
+		/// Start playing sample from offset according to the region loop
+		/// settings, the frames after the head of a streamed sample come
+		/// from stream and the crossfaded loop end from seam
+		void Start(const Sample* sample, const Region* region, long offset, Stream* stream = 0,
+			   const LoopSeam* seam = 0);
+
+		/// Set the playback speed, 1.0 is the original pitch at the sample rate
+		void SetStep(double step) { _step = step; }
+
+		/// Note-off: a sustain loop plays on through to the end
+		void Release() { _released = true; }
+
+		/// Render up to frames frames into out[channel], returns the frames written
+		int Render(float* const* out, int frames, const Resampler& resampler);
+
+		bool Finished() const { return _finished; }
+		double Position() const { return _pos; }
+
+		/// Frames left to play at the current step, -1 while looping
+		long Remaining() const
+		{
+			if (_finished)
+				return 0;
+			return looping() ? -1 : long((_end - _pos) / _step) + 1;
+		}
+		int Channels() const { return _sample ? _sample->Channels() : 0; }
+
+	private:
+		bool looping() const
+		{
+			return _loop_mode == LOOP_CONTINOUS || (_loop_mode == LOOP_SUSTAIN && !_released);
+		}
+		float edge(int channel, const Resampler& resampler, long available) const;
+
+		/// Frames of an integer sample decoded per run, besides the taps
+		enum { DECODE_FRAMES = 256 };
+
+		const Sample* _sample;
+		Stream* _stream;
+		const LoopSeam* _seam;
+		long _head;
+		double _pos;
+		double _step;
+		long _end;
+		long _loop_start;
+		long _loop_end;
+		loop_mode_t _loop_mode;
+		bool _released;
+		bool _finished;
+		float _decoded[DECODE_FRAMES + Resampler::MAX_BEFORE + Resampler::MAX_AFTER + 3];
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_PLAYBACK_H
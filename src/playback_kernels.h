@@ -0,0 +1,192 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_PLAYBACK_KERNELS_H
+#define LIBSFZ_PLAYBACK_KERNELS_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Interpolation kernels shared by the per instruction set translation
+// units. Not part of the public interface.
+
+#include "playback.h"
+#include "simd.h"
+
+namespace sfz
+{
+namespace kernels
+{
+
+	enum { SINC_TAPS = 8, SINC_PHASES = 256 };
+
+	// positions are rebased every CHUNK frames so that the offsets
+	// within a chunk keep full precision as single floats
+	enum { CHUNK = 64 };
+
+	/// Windowed sinc coefficients, per phase SINC_TAPS values followed
+	/// by SINC_TAPS deltas to the next phase
+	const float* sinc_table();
+
+#if defined(LIBSFZ_HAVE_AVX2)
+	/// Kernel compiled for AVX2, defined in playback_avx2.cpp
+	resample_fn avx2_kernel(interpolation_t quality);
+#endif
+
+	// one copy per translation unit, see simd.h
+	namespace
+	{
+
+	/////////////////////////////////////////////////////////////
+	// struct linear_op
+
+	struct linear_op
+	{
+		template<class S>
+		static typename S::V at(const float* p, typename S::V rel)
+		{
+			typename S::I i = S::trunc(rel);
+			typename S::V f = S::sub(rel, S::to_float(i));
+			typename S::V a = S::gather(p, i);
+			typename S::V b = S::gather(p + 1, i);
+			return S::madd(S::sub(b, a), f, a);
+		}
+	};
+
+	/////////////////////////////////////////////////////////////
+	// struct cubic_op
+
+	// 4-point, 3rd order Hermite (Catmull-Rom)
+	struct cubic_op
+	{
+		template<class S>
+		static typename S::V at(const float* p, typename S::V rel)
+		{
+			typename S::I i = S::trunc(rel);
+			typename S::V f = S::sub(rel, S::to_float(i));
+			typename S::V xm1 = S::gather(p - 1, i);
+			typename S::V x0 = S::gather(p, i);
+			typename S::V x1 = S::gather(p + 1, i);
+			typename S::V x2 = S::gather(p + 2, i);
+			typename S::V half = S::set1(0.5f);
+
+			typename S::V c1 = S::mul(half, S::sub(x1, xm1));
+			typename S::V c2 = S::add(S::sub(xm1, S::mul(S::set1(2.5f), x0)),
+						  S::sub(S::add(x1, x1), S::mul(half, x2)));
+			typename S::V c3 = S::madd(half, S::sub(x2, xm1), S::mul(S::set1(1.5f), S::sub(x0, x1)));
+
+			return S::madd(S::madd(S::madd(c3, f, c2), f, c1), f, x0);
+		}
+	};
+
+	/////////////////////////////////////////////////////////////
+	// resample kernels
+
+	template<class S, class OP>
+	void
+	resample(const float* data, double pos, double step, float* out, int frames)
+	{
+		const typename S::V lanes = S::ramp();
+		const float fstep = float(step);
+
+		while (frames > 0)
+		{
+			int n = frames < CHUNK ? frames : CHUNK;
+			long base = (long) pos;
+			const float* p = data + base;
+			const float frac = float(pos - base);
+
+			const typename S::V vstep = S::set1(fstep);
+			const typename S::V vfrac = S::set1(frac);
+
+			int i = 0;
+			for (; i + S::width <= n; i += S::width)
+			{
+				typename S::V rel = S::madd(S::add(lanes, S::set1(float(i))), vstep, vfrac);
+				S::storeu(out + i, OP::template at<S>(p, rel));
+			}
+			for (; i < n; ++i)
+				out[i] = OP::template at<simd::scalar_t>(p, frac + i * fstep);
+
+			out += n;
+			frames -= n;
+			pos += n * step;
+		}
+	}
+
+	// the sinc kernel is vectorized over the taps of one frame
+	template<class S>
+	void
+	resample_sinc(const float* data, double pos, double step, float* out, int frames)
+	{
+		const float* table = sinc_table();
+		const float fstep = float(step);
+
+		while (frames > 0)
+		{
+			int n = frames < CHUNK ? frames : CHUNK;
+			long base = (long) pos;
+			const float* p = data + base;
+			const float frac = float(pos - base);
+
+			for (int i = 0; i < n; ++i)
+			{
+				float rel = frac + i * fstep;
+				int idx = (int) rel;
+				float phase = (rel - idx) * SINC_PHASES;
+				int ip = (int) phase;
+				const float* row = table + ip * 2 * SINC_TAPS;
+				const float* taps = p + idx - 3;
+
+				typename S::V pf = S::set1(phase - ip);
+				typename S::V acc = S::set1(0.0f);
+				for (int k = 0; k < SINC_TAPS; k += S::width)
+				{
+					typename S::V c = S::madd(S::loadu(row + SINC_TAPS + k), pf, S::loadu(row + k));
+					acc = S::madd(S::loadu(taps + k), c, acc);
+				}
+				out[i] = S::hsum(acc);
+			}
+
+			out += n;
+			frames -= n;
+			pos += n * step;
+		}
+	}
+
+	template<class S>
+	resample_fn
+	kernel(interpolation_t quality)
+	{
+		switch (quality)
+		{
+		case INTERPOLATION_LINEAR:
+			return &resample<S, linear_op>;
+		case INTERPOLATION_CUBIC:
+			return &resample<S, cubic_op>;
+		case INTERPOLATION_SINC:
+			return &resample_sinc<S>;
+		}
+		return &resample<S, cubic_op>;
+	}
+
+	} // !namespace
+
+} // !namespace kernels
+} // !namespace sfz
+
+#endif // !LIBSFZ_PLAYBACK_KERNELS_H
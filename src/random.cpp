@@ -0,0 +1,63 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "random.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Random
+
+	Random::Random(boost::uint32_t seed)
+	{
+		Seed(seed);
+	}
+
+	Random::~Random()
+	{
+	}
+
+	void
+	Random::Seed(boost::uint32_t seed)
+	{
+		// splitmix32 spreads the seed over the state, which is never all zero
+		for (int i = 0; i < 4; ++i)
+		{
+			boost::uint32_t z = (seed += 0x9e3779b9u);
+			z = (z ^ (z >> 16)) * 0x85ebca6bu;
+			z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+			_s[i] = z ^ (z >> 16);
+		}
+		if (!(_s[0] | _s[1] | _s[2] | _s[3]))
+			_s[0] = 1;
+	}
+
+	void
+	Random::Fill(draws_t& draws, boost::uint32_t seed)
+	{
+		Random note(seed);
+		draws.seed = seed;
+		for (int i = 0; i < DRAW_COUNT; ++i)
+			draws.value[i] = note.Uniform();
+	}
+
+} // !namespace sfz
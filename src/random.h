@@ -0,0 +1,93 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_RANDOM_H
+#define LIBSFZ_RANDOM_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <boost/cstdint.hpp>
+
+namespace sfz
+{
+
+	// Draws of a note-on, one per random opcode
+	enum random_draw_t { DRAW_RAND,      // lorand/hirand
+			     DRAW_AMP,       // amp_random
+			     DRAW_PITCH,     // pitch_random
+			     DRAW_CUTOFF,    // fil_random
+			     DRAW_CUTOFF2,   // fil2_random
+			     DRAW_OFFSET,    // offset_random
+			     DRAW_DELAY,     // delay_random
+			     DRAW_COUNT };
+
+	/// Uniform draws (0-1) of one note-on and the seed they came from
+	struct draws_t
+	{
+		boost::uint32_t seed;
+		float value[DRAW_COUNT];
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class Random
+
+	/// Small, fast and seedable generator (xoshiro128+)
+	///
+	/// The engine draws the seed of every note-on from one Random and
+	/// expands it into a draws_t for all random opcodes at once. Output
+	/// only depends on the seed and the order of the events, and a
+	/// voice starting later (delay) rebuilds the draws of its note from
+	/// the seed alone.
+	class Random
+	{
+	public:
+		Random(boost::uint32_t seed = 1);
+		virtual ~Random();
+
+		/// Restart the sequence of seed
+		void Seed(boost::uint32_t seed);
+
+		boost::uint32_t Next()
+		{
+			boost::uint32_t result = _s[0] + _s[3];
+			boost::uint32_t t = _s[1] << 9;
+			_s[2] ^= _s[0];
+			_s[3] ^= _s[1];
+			_s[1] ^= _s[2];
+			_s[0] ^= _s[3];
+			_s[2] ^= t;
+			_s[3] = (_s[3] << 11) | (_s[3] >> 21);
+			return result;
+		}
+
+		/// Uniform in [0, 1), from the 24 high bits
+		float Uniform() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+
+		/// Draws of a new note-on
+		void Draw(draws_t& draws) { Fill(draws, Next()); }
+
+		/// Draws of the note-on with seed
+		static void Fill(draws_t& draws, boost::uint32_t seed);
+
+	private:
+		boost::uint32_t _s[4];
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_RANDOM_H
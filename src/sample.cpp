@@ -0,0 +1,138 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <cstring>
+
+#include "sample.h"
+#include "wav_kernels.h"
+
+namespace sfz
+{
+
+	// PCM kernel of the best instruction set, the same one WavFile uses
+	static WavFile::convert_fn
+	pcm_kernel()
+	{
+#if defined(LIBSFZ_HAVE_AVX2)
+		if (simd::HasAVX2())
+			return kernels::avx2_pcm();
+#endif
+		return &kernels::convert_pcm<simd::native_t>;
+	}
+
+	static const WavFile::convert_fn decode_pcm = pcm_kernel();
+
+	/////////////////////////////////////////////////////////////
+	// class Sample
+
+	Sample::Sample() :
+		loop_start(-1),
+		loop_end(-1),
+		_channels(0),
+		_frames(0),
+		_preloaded(0),
+		_rate(44100),
+		_format(SAMPLE_FLOAT)
+	{
+		_channel[0] = _channel[1] = 0;
+	}
+
+	Sample::Sample(int channels, long frames, float rate, sample_format_t format) :
+		loop_start(-1),
+		loop_end(-1)
+	{
+		Resize(channels, frames, rate, -1, format);
+	}
+
+	Sample::~Sample()
+	{
+	}
+
+	void
+	Sample::Resize(int channels, long frames, float rate, long preloaded, sample_format_t format)
+	{
+		// one cache line more to align the first
+		_memory.assign(Layout(channels, frames, preloaded, format) + 64, 0);
+		unsigned char* memory = &_memory[0] + ((64 - (size_t(&_memory[0]) & 63)) & 63);
+		Place(channels, frames, rate, preloaded, format, memory, boost::shared_ptr<void>());
+	}
+
+	void
+	Sample::Place(int channels, long frames, float rate, long preloaded, sample_format_t format,
+		      unsigned char* memory, const boost::shared_ptr<void>& owner)
+	{
+		// only mono and stereo samples are supported
+		_channels = (channels > 1) ? 2 : 1;
+		_frames = frames;
+		_preloaded = (preloaded >= 0 && preloaded < frames) ? preloaded : frames;
+		_rate = rate;
+		_format = format;
+		_owner = owner;
+		if (owner)
+			std::vector<unsigned char>().swap(_memory);
+
+		// the guard before the first frame is a cache line
+		size_t bytes = channel_bytes(frames, preloaded, format);
+		_channel[0] = memory + 64;
+		_channel[1] = (_channels > 1) ? memory + bytes + 64 : 0;
+	}
+
+	size_t
+	Sample::Layout(int channels, long frames, long preloaded, sample_format_t format)
+	{
+		return ((channels > 1) ? 2 : 1) * channel_bytes(frames, preloaded, format);
+	}
+
+	size_t
+	Sample::channel_bytes(long frames, long preloaded, sample_format_t format)
+	{
+		// a cache line of guard, the frames and the guard after them,
+		// channels start on cache lines
+		if (preloaded < 0 || preloaded > frames)
+			preloaded = frames;
+		size_t bytes = 64 + (preloaded + GUARD) * Width(format);
+		return (bytes + 63) & ~size_t(63);
+	}
+
+	void
+	Sample::Decode(int channel, long start, long frames, float* out) const
+	{
+		if (_format == SAMPLE_FLOAT)
+		{
+			std::memcpy(out, Data(channel) + start, frames * sizeof(float));
+			return;
+		}
+		int width = Width();
+		decode_pcm(Packed(channel) + (start + 1) * width - 4, width, width * 8, false, out, frames);
+	}
+
+	float
+	Sample::get(int channel, long frame) const
+	{
+		int width = Width();
+		int word;
+		std::memcpy(&word, Packed(channel) + (frame + 1) * width - 4, 4);
+		word &= int(~0u << (32 - width * 8));
+		return word * (1.0f / 2147483648.0f);
+	}
+
+} // !namespace sfz
@@ -0,0 +1,132 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SAMPLE_H
+#define LIBSFZ_SAMPLE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace sfz
+{
+
+	// Enumerations
+	enum sample_format_t { SAMPLE_FLOAT, SAMPLE_INT16, SAMPLE_INT24 };
+
+	/////////////////////////////////////////////////////////////
+	// class Sample
+
+	/// Decoded audio of a sample file, one array per channel
+	///
+	/// A streamed sample only holds its first Preloaded() frames, the
+	/// frames after that are read from disk while a voice plays.
+	///
+	/// Float samples are played straight from Data(). Integer samples
+	/// keep little endian 16 or 24 bit words in Packed(), which can
+	/// each be read as the 32 bit word ending with them, and are turned
+	/// into floats with Decode() a run at a time. The frames live in
+	/// memory of the sample itself or in memory handed to Place(), such
+	/// as a shared mapping.
+	///
+	/// The first frame of every channel is 64 byte aligned and at least
+	/// GUARD frames of silence precede it and follow the last, so
+	/// kernels may read past either end without checking.
+	class Sample
+	{
+	public:
+		Sample();
+		Sample(int channels, long frames, float rate, sample_format_t format = SAMPLE_FLOAT);
+		virtual ~Sample();
+
+		/// Allocate (and clear) storage for the given format, holding
+		/// only the first preloaded frames if that is not negative
+		void Resize(int channels, long frames, float rate, long preloaded = -1,
+			    sample_format_t format = SAMPLE_FLOAT);
+
+		/// Like Resize() but keep the frames in the Layout() bytes at
+		/// memory, which owner frees once the sample is gone; the
+		/// memory is used as it is
+		void Place(int channels, long frames, float rate, long preloaded, sample_format_t format,
+			   unsigned char* memory, const boost::shared_ptr<void>& owner);
+
+		/// Bytes of memory taken by the frames of a sample of that shape,
+		/// Place() wants them 64 byte aligned
+		static size_t Layout(int channels, long frames, long preloaded, sample_format_t format);
+
+		/// Silent frames before the first and after the last frame
+		enum { GUARD = 8 };
+
+		/// Frames of a float sample
+		const float* Data(int channel) const { return (const float*) _channel[channel]; }
+		float* Data(int channel) { return (float*) _channel[channel]; }
+
+		/// Words of an integer sample, Width() bytes per frame
+		const unsigned char* Packed(int channel) const { return _channel[channel]; }
+		unsigned char* Packed(int channel) { return _channel[channel]; }
+
+		/// Convert frames frames of channel starting at start into out
+		void Decode(int channel, long start, long frames, float* out) const;
+
+		/// A single frame of channel, whatever the format
+		float Get(int channel, long frame) const
+		{
+			return (_format == SAMPLE_FLOAT) ? Data(channel)[frame] : get(channel, frame);
+		}
+
+		int Channels() const { return _channels; }
+		long Frames() const { return _frames; }
+		long Preloaded() const { return _preloaded; }
+		float Rate() const { return _rate; }
+		sample_format_t Format() const { return _format; }
+
+		/// Bytes per frame and channel held in memory
+		int Width() const { return Width(_format); }
+		static int Width(sample_format_t format) { return (format == SAMPLE_FLOAT) ? 4 : (format == SAMPLE_INT16) ? 2 : 3; }
+
+		/// Memory held by the decoded frames
+		size_t Bytes() const { return size_t(_preloaded) * _channels * Width(); }
+
+		/// Loop points stored in the file, -1 if there are none
+		long loop_start;
+		long loop_end;
+
+	private:
+		Sample(const Sample&);
+		Sample& operator=(const Sample&);
+
+		float get(int channel, long frame) const;
+		static size_t channel_bytes(long frames, long preloaded, sample_format_t format);
+
+		int _channels;
+		long _frames;
+		long _preloaded;
+		float _rate;
+		sample_format_t _format;
+		unsigned char* _channel[2];
+		std::vector<unsigned char> _memory;
+		boost::shared_ptr<void> _owner;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_SAMPLE_H
@@ -0,0 +1,263 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "samplecache.h"
+#include "samplestore.h"
+#include "wav.h"
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SampleCache
+
+	SampleCache::SampleCache(double budget, int capacity) :
+		_capacity(capacity),
+		_entries(new entry_t[capacity]),
+		_budget(budget),
+		_bodies(0),
+		_bytes(0),
+		_evictions(0),
+		_tick(0),
+		_hits(0),
+		_misses(0)
+	{
+		for (int i = 0; i < _capacity; ++i)
+		{
+			_entries[i].body.store(0);
+			_entries[i].users.store(0);
+			_entries[i].pins.store(0);
+			_entries[i].wanted.store(false);
+			_entries[i].last.store(0);
+			_entries[i].storage = STORAGE_FLOAT;
+		}
+	}
+
+	SampleCache::~SampleCache()
+	{
+		SampleStore& store = SampleStore::Instance();
+		for (int i = 0; i < entries(); ++i)
+			if (const Sample* body = _entries[i].body.load())
+				store.Release(i, body);
+	}
+
+	// size of the body of sample in storage as given by the file
+	// header, 0 if the file cannot be opened
+	static double
+	body_bytes(int sample, storage_t storage)
+	{
+		WavFile wav;
+		if (!wav.Open(SampleStore::Instance().Path(sample)))
+			return 0;
+		int channels = (wav.Channels() > 1) ? 2 : 1;
+		return double(wav.Frames()) * channels * Sample::Width(SampleStore::Format(wav, storage));
+	}
+
+	void
+	SampleCache::Load(const Instrument* instrument, SampleLoader* loader)
+	{
+		// bodies are chosen from their headers first, so nothing is read
+		// that would not fit
+		std::set<int> seen;
+		std::vector<int> ids;
+		double bytes = _bytes;
+		for (size_t i = 0; i < instrument->regions.size(); ++i)
+		{
+			int id = instrument->regions[i]->sample;
+			if (id < 0 || id >= _capacity || !seen.insert(id).second || _entries[id].body.load())
+				continue;
+			_entries[id].storage = instrument->storage;
+			double size = body_bytes(id, instrument->storage);
+			if (size == 0 || (_budget > 0 && bytes + size > _budget))
+				continue;
+			bytes += size;
+			ids.push_back(id);
+		}
+
+		SampleLoader pool;
+		if (!loader)
+			loader = &pool;
+		loader->Clear();
+		for (size_t i = 0; i < ids.size(); ++i)
+			loader->Add(ids[i], -1, instrument->storage);
+		loader->Run();
+
+		for (size_t i = 0; i < ids.size(); ++i)
+		{
+			const Sample* body = loader->Get(i);
+			if (!body)
+				std::cerr << "The sample '" << SampleStore::Instance().Path(ids[i]) << "' could not be loaded by libsfz!" << std::endl;
+			else
+				insert(ids[i], body);
+		}
+	}
+
+	void
+	SampleCache::Maintain()
+	{
+		// bodies missed or pinned, pinned ones first and then the ones
+		// triggered most recently
+		std::vector<std::pair<boost::uint64_t, int> > wanted;
+		for (int i = 0; i < entries(); ++i)
+		{
+			entry_t& entry = _entries[i];
+			bool missed = entry.wanted.exchange(false);
+			if (entry.body.load())
+				continue;
+			if (entry.pins.load() > 0)
+				wanted.push_back(std::make_pair(~boost::uint64_t(0), i));
+			else if (missed)
+				wanted.push_back(std::make_pair(entry.last.load(), i));
+		}
+		std::sort(wanted.rbegin(), wanted.rend());
+
+		SampleStore& store = SampleStore::Instance();
+		for (size_t i = 0; i < wanted.size(); ++i)
+		{
+			int id = wanted[i].second;
+			storage_t storage = _entries[id].storage;
+			double size = body_bytes(id, storage);
+			if (size == 0 || !make_room(size))
+				continue;
+			const Sample* body = store.Acquire(id, -1, storage);
+			if (body)
+				insert(id, body);
+		}
+
+		make_room(0);
+	}
+
+	const Sample*
+	SampleCache::Play(int sample)
+	{
+		if (sample < 0 || sample >= _capacity)
+			return 0;
+
+		// the user is counted before the body is looked at and evict()
+		// clears the body before it looks at the users, so of the two
+		// at least one sees the other
+		entry_t& entry = _entries[sample];
+		entry.last.store(++_tick, boost::memory_order_relaxed);
+		entry.users.fetch_add(1);
+		const Sample* body = entry.body.load();
+		if (body)
+		{
+			_hits.fetch_add(1, boost::memory_order_relaxed);
+			return body;
+		}
+		entry.users.fetch_sub(1);
+		entry.wanted.store(true, boost::memory_order_relaxed);
+		_misses.fetch_add(1, boost::memory_order_relaxed);
+		return 0;
+	}
+
+	void
+	SampleCache::Stop(int sample)
+	{
+		if (sample >= 0 && sample < _capacity)
+			_entries[sample].users.fetch_sub(1);
+	}
+
+	void
+	SampleCache::Pin(int sample)
+	{
+		if (sample >= 0 && sample < _capacity)
+			_entries[sample].pins.fetch_add(1);
+	}
+
+	void
+	SampleCache::Unpin(int sample)
+	{
+		if (sample >= 0 && sample < _capacity)
+			_entries[sample].pins.fetch_sub(1);
+	}
+
+	double
+	SampleCache::HitRate() const
+	{
+		double hits = Hits();
+		double total = hits + Misses();
+		return (total > 0) ? hits / total : 0.0;
+	}
+
+	bool
+	SampleCache::evict(int sample)
+	{
+		entry_t& entry = _entries[sample];
+		const Sample* body = entry.body.exchange(0);
+		if (!body)
+			return false;
+		if (entry.users.load() > 0)
+		{
+			// a voice took it meanwhile
+			entry.body.store(body);
+			return false;
+		}
+		_bytes -= body->Bytes();
+		--_bodies;
+		++_evictions;
+		SampleStore::Instance().Release(sample, body);
+		return true;
+	}
+
+	bool
+	SampleCache::make_room(double bytes)
+	{
+		if (_budget <= 0 || _bytes + bytes <= _budget)
+			return true;
+
+		// least recently triggered first, pinned and playing bodies stay
+		std::vector<std::pair<boost::uint64_t, int> > victims;
+		for (int i = 0; i < entries(); ++i)
+		{
+			entry_t& entry = _entries[i];
+			if (entry.body.load() && entry.pins.load() <= 0 && entry.users.load() <= 0)
+				victims.push_back(std::make_pair(entry.last.load(), i));
+		}
+		std::sort(victims.begin(), victims.end());
+
+		for (size_t i = 0; i < victims.size() && _bytes + bytes > _budget; ++i)
+			evict(victims[i].second);
+		return _bytes + bytes <= _budget;
+	}
+
+	void
+	SampleCache::insert(int sample, const Sample* body)
+	{
+		_bytes += body->Bytes();
+		++_bodies;
+		_entries[sample].body.store(body);
+	}
+
+	int
+	SampleCache::entries() const
+	{
+		return std::min(SampleStore::Instance().Size(), _capacity);
+	}
+
+} // !namespace sfz
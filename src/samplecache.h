@@ -0,0 +1,130 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SAMPLECACHE_H
+#define LIBSFZ_SAMPLECACHE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "sfz.h"
+#include "sample.h"
+#include "sampleloader.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SampleCache
+
+	/// Whole sample bodies held in memory within a byte budget
+	///
+	/// The bodies sit on top of the heads preloaded by a DiskStreamer: a
+	/// voice whose sample body is cached plays it from memory, any other
+	/// voice streams after the head. When the budget is exceeded the
+	/// bodies triggered least recently are evicted, so an instrument
+	/// always loads and only streams more as memory gets tight. Samples
+	/// can be pinned, a pinned body is never evicted.
+	///
+	/// Play(), Stop(), Pin() and Unpin() are lock free and meant for the
+	/// audio thread, everything else reads or frees audio and must run on
+	/// another thread. Entries are kept by SampleStore id, ids from
+	/// capacity on are never cached.
+	class SampleCache
+	{
+	public:
+		/// Keep at most budget bytes of bodies, no limit if 0
+		SampleCache(double budget = 0, int capacity = 65536);
+		virtual ~SampleCache();
+
+		/// Read the bodies of the samples of instrument as long as they
+		/// fit in the budget, with loader if given; they are kept and
+		/// read back later in the storage of the instrument
+		void Load(const Instrument* instrument, SampleLoader* loader = 0);
+
+		/// Change the budget, takes effect on the next Maintain()
+		void SetBudget(double budget) { _budget = budget; }
+		double Budget() const { return _budget; }
+
+		/// Evict bodies down to the budget and read the ones missed or
+		/// pinned since the last call if they fit, call it regularly
+		void Maintain();
+
+		/// Body of sample for a voice starting to play it, NULL if the
+		/// body is not in memory; a body returned stays until Stop()
+		const Sample* Play(int sample);
+
+		/// The voice started by a successful Play() is done with sample
+		void Stop(int sample);
+
+		/// Keep the body of sample in memory until a matching Unpin()
+		void Pin(int sample);
+		void Unpin(int sample);
+
+		/// Bodies held and the bytes they take
+		int Bodies() const { return _bodies; }
+		double Bytes() const { return _bytes; }
+
+		/// Play() calls that found the body and that did not
+		unsigned long Hits() const { return _hits.load(boost::memory_order_relaxed); }
+		unsigned long Misses() const { return _misses.load(boost::memory_order_relaxed); }
+		double HitRate() const;
+
+		/// Bodies evicted so far
+		unsigned long Evictions() const { return _evictions; }
+
+	private:
+		SampleCache(const SampleCache&);
+		SampleCache& operator=(const SampleCache&);
+
+		struct entry_t
+		{
+			boost::atomic<const Sample*> body;
+			boost::atomic<int> users;
+			boost::atomic<int> pins;
+			boost::atomic<bool> wanted;
+			boost::atomic<boost::uint64_t> last;
+			storage_t storage;
+		};
+
+		bool evict(int sample);
+		bool make_room(double bytes);
+		void insert(int sample, const Sample* body);
+		int entries() const;
+
+		int _capacity;
+		boost::scoped_array<entry_t> _entries;
+		double _budget;
+
+		// only touched off the audio thread
+		int _bodies;
+		double _bytes;
+		unsigned long _evictions;
+
+		boost::atomic<boost::uint64_t> _tick;
+		boost::atomic<unsigned long> _hits;
+		boost::atomic<unsigned long> _misses;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_SAMPLECACHE_H
@@ -0,0 +1,122 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "sampleloader.h"
+#include "samplestore.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SampleLoader
+
+	SampleLoader::SampleLoader(int threads) :
+		_threads(threads),
+		_next(0),
+		_done(0),
+		_total(0),
+		_bytes(0),
+		_elapsed(0)
+	{
+		if (_threads <= 0)
+			_threads = boost::thread::hardware_concurrency();
+		if (_threads <= 0)
+			_threads = 1;
+	}
+
+	SampleLoader::~SampleLoader()
+	{
+	}
+
+	void
+	SampleLoader::Add(int sample, long frames, storage_t storage)
+	{
+		request_t request;
+		request.sample = sample;
+		request.frames = frames;
+		request.storage = storage;
+		request.result = 0;
+		_requests.push_back(request);
+	}
+
+	void
+	SampleLoader::Clear()
+	{
+		_requests.clear();
+	}
+
+	void
+	SampleLoader::Run()
+	{
+		_next.store(0);
+		_done.store(0);
+		_total.store(_requests.size());
+		_bytes.store(0);
+		_elapsed.store(0);
+		_start = boost::posix_time::microsec_clock::universal_time();
+
+		// no point in more workers than files
+		int threads = (_threads < int(_requests.size())) ? _threads : int(_requests.size());
+		if (threads <= 1)
+		{
+			work();
+			return;
+		}
+
+		boost::thread_group workers;
+		for (int t = 0; t < threads; ++t)
+			workers.create_thread(boost::bind(&SampleLoader::work, this));
+		workers.join_all();
+	}
+
+	double
+	SampleLoader::Throughput() const
+	{
+		double seconds = Seconds();
+		return (seconds > 0) ? Bytes() / seconds : 0;
+	}
+
+	void
+	SampleLoader::work()
+	{
+		SampleStore& store = SampleStore::Instance();
+		for (;;)
+		{
+			int i = _next.fetch_add(1, boost::memory_order_relaxed);
+			if (i >= int(_requests.size()))
+				break;
+
+			request_t& request = _requests[i];
+			double bytes = 0;
+			request.result = store.Acquire(request.sample, request.frames, request.storage, &bytes);
+
+			_bytes.fetch_add(boost::uint64_t(bytes), boost::memory_order_relaxed);
+			_done.fetch_add(1, boost::memory_order_relaxed);
+			boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - _start;
+			_elapsed.store(long(elapsed.total_microseconds()), boost::memory_order_relaxed);
+		}
+	}
+
+} // !namespace sfz
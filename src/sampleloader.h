@@ -0,0 +1,104 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SAMPLELOADER_H
+#define LIBSFZ_SAMPLELOADER_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "sfz.h"
+#include "sample.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SampleLoader
+
+	/// Reads samples into the SampleStore on a pool of worker threads
+	///
+	/// Requests are queued with Add() and decoded by Run(), each worker
+	/// taking the next request until none is left, so a bank of many
+	/// files keeps every core and the disk busy. Progress can be polled
+	/// from another thread while Run() works.
+	class SampleLoader
+	{
+	public:
+		/// Use threads workers, one per core if 0
+		SampleLoader(int threads = 0);
+		virtual ~SampleLoader();
+
+		/// Queue a reference to the first frames frames of the sample
+		/// with SampleStore id sample, all of them if negative, to be
+		/// kept in storage
+		void Add(int sample, long frames = -1, storage_t storage = STORAGE_FLOAT);
+
+		/// Acquire every queued sample, returns when all are done
+		void Run();
+
+		/// Forget the requests, the references taken stay with the caller
+		void Clear();
+
+		/// Audio of request i after Run(), NULL if it could not be read
+		const Sample* Get(int i) const { return _requests[i].result; }
+		int Size() const { return _requests.size(); }
+
+		/// Requests done and queued by the current or last Run()
+		int Done() const { return _done.load(boost::memory_order_relaxed); }
+		int Total() const { return _total.load(boost::memory_order_relaxed); }
+
+		/// Bytes read from disk and seconds spent by the current or last Run()
+		double Bytes() const { return double(_bytes.load(boost::memory_order_relaxed)); }
+		double Seconds() const { return _elapsed.load(boost::memory_order_relaxed) / 1e6; }
+
+		/// Bytes read per second
+		double Throughput() const;
+
+		int Threads() const { return _threads; }
+
+	private:
+		struct request_t
+		{
+			int sample;
+			long frames;
+			storage_t storage;
+			const Sample* result;
+		};
+
+		void work();
+
+		int _threads;
+		std::vector<request_t> _requests;
+		boost::posix_time::ptime _start;
+
+		boost::atomic<int> _next;
+		boost::atomic<int> _done;
+		boost::atomic<int> _total;
+		boost::atomic<boost::uint64_t> _bytes;
+		boost::atomic<long> _elapsed;   // microseconds
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_SAMPLELOADER_H
@@ -0,0 +1,275 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "samplestore.h"
+#include "sharedpool.h"
+#include "pcmcache.h"
+#include "wav.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SampleStore
+
+	SampleStore::SampleStore() :
+		_shared(false),
+		_cache_limit(0)
+	{
+	}
+
+	SampleStore::~SampleStore()
+	{
+		for (size_t i = 0; i < _entries.size(); ++i)
+			for (size_t h = 0; h < _entries[i].held.size(); ++h)
+				delete _entries[i].held[h].sample;
+	}
+
+	SampleStore&
+	SampleStore::Instance()
+	{
+		static SampleStore store;
+		return store;
+	}
+
+	int
+	SampleStore::Intern(const std::string& path)
+	{
+		std::string key = Resolve(path);
+		boost::mutex::scoped_lock lock(_mutex);
+
+		std::map<std::string, int>::iterator it = _ids.find(key);
+		if (it != _ids.end())
+			return it->second;
+
+		entry_t entry;
+		entry.path = key;
+		_entries.push_back(entry);
+		return _ids[key] = _entries.size() - 1;
+	}
+
+	int
+	SampleStore::Find(const std::string& path) const
+	{
+		std::string key = Resolve(path);
+		boost::mutex::scoped_lock lock(_mutex);
+
+		std::map<std::string, int>::const_iterator it = _ids.find(key);
+		return (it != _ids.end()) ? it->second : -1;
+	}
+
+	std::string
+	SampleStore::Path(int id) const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return _entries[id].path;
+	}
+
+	int
+	SampleStore::Size() const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return _entries.size();
+	}
+
+	void
+	SampleStore::SetShared(bool shared)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		_shared = shared;
+	}
+
+	bool
+	SampleStore::Shared() const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return _shared;
+	}
+
+	void
+	SampleStore::SetCacheDirectory(const std::string& directory, double limit)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		_directory = directory;
+		_cache_limit = limit;
+	}
+
+	std::string
+	SampleStore::CacheDirectory() const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return _directory;
+	}
+
+	const Sample*
+	SampleStore::Acquire(int id, long frames, storage_t storage, double* bytes)
+	{
+		std::string path;
+		std::string directory;
+		double limit;
+		bool shared;
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			entry_t& entry = _entries[id];
+			int h = find(entry.held, frames, storage);
+			if (h >= 0)
+			{
+				++entry.held[h].references;
+				return entry.held[h].sample;
+			}
+			path = entry.path;
+			shared = _shared;
+			directory = _directory;
+			limit = _cache_limit;
+		}
+
+		// read without holding the lock, other files can load meanwhile
+		WavFile wav;
+		if (!wav.Open(path))
+			return 0;
+		sample_format_t format = Format(wav, storage);
+		Sample* sample = 0;
+		if (!directory.empty())
+			sample = PcmCache::Map(directory, path, wav, frames, format, limit, bytes);
+		if (!sample && shared)
+			sample = SharedPool::Map(path, wav, frames, format, bytes);
+		if (!sample)
+		{
+			sample = new Sample();
+			sample->Resize(wav.Channels(), wav.Frames(), wav.Rate(), frames, format);
+			long read = wav.Read(sample);
+			if (bytes)
+				*bytes += double(read) * wav.FrameSize();
+		}
+
+		boost::mutex::scoped_lock lock(_mutex);
+		entry_t& entry = _entries[id];
+		int h = find(entry.held, frames, storage);
+		if (h >= 0)
+		{
+			// somebody else read it in the meantime
+			delete sample;
+		}
+		else
+		{
+			held_t held = { sample, storage, 0 };
+			entry.held.push_back(held);
+			h = entry.held.size() - 1;
+		}
+		++entry.held[h].references;
+		return entry.held[h].sample;
+	}
+
+	void
+	SampleStore::Release(int id, const Sample* sample)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		std::vector<held_t>& held = _entries[id].held;
+		for (size_t h = 0; h < held.size(); ++h)
+		{
+			if (held[h].sample != sample)
+				continue;
+			if (--held[h].references <= 0)
+			{
+				delete held[h].sample;
+				held.erase(held.begin() + h);
+			}
+			return;
+		}
+	}
+
+	int
+	SampleStore::References(int id) const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		int references = 0;
+		const std::vector<held_t>& held = _entries[id].held;
+		for (size_t h = 0; h < held.size(); ++h)
+			references += held[h].references;
+		return references;
+	}
+
+	sample_format_t
+	SampleStore::Format(const WavFile& wav, storage_t storage)
+	{
+		if (storage != STORAGE_COMPACT || wav.IsFloat() || wav.Bits() > 24)
+			return SAMPLE_FLOAT;
+		return (wav.Bits() <= 16) ? SAMPLE_INT16 : SAMPLE_INT24;
+	}
+
+	int
+	SampleStore::find(const std::vector<held_t>& held, long frames, storage_t storage)
+	{
+		int best = -1;
+		for (size_t h = 0; h < held.size(); ++h)
+		{
+			const Sample* sample = held[h].sample;
+			if (held[h].storage != storage)
+				continue;
+			bool whole = frames < 0 || frames >= sample->Frames();
+			bool covers = whole ? sample->Preloaded() == sample->Frames() :
+				(sample->Preloaded() >= frames && sample->Preloaded() < sample->Frames());
+			if (covers && (best < 0 || sample->Preloaded() < held[best].sample->Preloaded()))
+				best = h;
+		}
+		return best;
+	}
+
+	std::string
+	SampleStore::Resolve(const std::string& path)
+	{
+		std::vector<std::string> parts;
+		std::string part;
+		bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+
+		for (size_t i = 0; i <= path.size(); ++i)
+		{
+			if (i < path.size() && path[i] != '/' && path[i] != '\\')
+			{
+				part += path[i];
+				continue;
+			}
+
+			if (part == "..")
+			{
+				// only a real directory can be stepped out of
+				if (!parts.empty() && parts.back() != "..")
+					parts.pop_back();
+				else if (!absolute)
+					parts.push_back(part);
+			}
+			else if (!part.empty() && part != ".")
+				parts.push_back(part);
+			part.clear();
+		}
+
+		std::string resolved = absolute ? "/" : "";
+		for (size_t i = 0; i < parts.size(); ++i)
+		{
+			if (i)
+				resolved += '/';
+			resolved += parts[i];
+		}
+		return resolved;
+	}
+
+} // !namespace sfz
@@ -0,0 +1,139 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SAMPLESTORE_H
+#define LIBSFZ_SAMPLESTORE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "sfz.h"
+#include "sample.h"
+#include "wav.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SampleStore
+
+	/// Process wide registry of the sample files of all instruments
+	///
+	/// Paths are resolved and interned to dense ids as instruments are
+	/// parsed, so a file used by many regions or instruments is known
+	/// once. The decoded audio of an id is reference counted: the first
+	/// Acquire() reads it, later ones share it, and the last Release()
+	/// frees it. Preloaded heads and whole bodies of a file are counted
+	/// apart, so a body can be let go of while its head stays. All
+	/// methods are thread safe but none is real-time safe.
+	class SampleStore
+	{
+	public:
+		/// The store of the process
+		static SampleStore& Instance();
+
+		/// Id of path after resolving it, a new id if it is not known yet
+		int Intern(const std::string& path);
+
+		/// Id of path, -1 if it was never interned
+		int Find(const std::string& path) const;
+
+		/// Resolved path of id
+		std::string Path(int id) const;
+
+		/// Number of ids handed out so far
+		int Size() const;
+
+		/// Take a reference to the audio of id holding at least the first
+		/// frames frames (all if negative), reading the file if needed
+		///
+		/// Returns NULL without taking a reference if the file cannot be
+		/// read. The smallest audio held in storage that covers frames
+		/// is shared, but a head is never served by a whole body. The
+		/// bytes read from disk are added to bytes if given.
+		const Sample* Acquire(int id, long frames = -1, storage_t storage = STORAGE_FLOAT,
+				      double* bytes = 0);
+
+		/// Drop a reference to sample taken by Acquire()
+		void Release(int id, const Sample* sample);
+
+		/// References held to the audio of id
+		int References(int id) const;
+
+		/// Decode audio read from now on into shared memory that every
+		/// other process using the same files maps instead of decoding
+		/// again, see SharedPool; audio that cannot be shared is kept
+		/// in private memory as usual
+		void SetShared(bool shared);
+		bool Shared() const;
+
+		/// Keep decoded audio in files of directory that later runs map
+		/// instead of decoding again, see PcmCache; this comes before
+		/// shared memory, whose sharing the mapped files already give.
+		/// An empty directory turns the cache off. The files are kept
+		/// within limit bytes, least recently used out first; with no
+		/// limit (0) the host has to clean the directory itself.
+		void SetCacheDirectory(const std::string& directory, double limit = 0);
+		std::string CacheDirectory() const;
+
+		/// Format wav is kept in with storage, integer PCM is only kept
+		/// compact where that is lossless
+		static sample_format_t Format(const WavFile& wav, storage_t storage);
+
+		/// Turn path into the key of the store: '\\' becomes '/' and
+		/// empty, "." and "dir/.." components are removed
+		static std::string Resolve(const std::string& path);
+
+	private:
+		SampleStore();
+		SampleStore(const SampleStore&);
+		SampleStore& operator=(const SampleStore&);
+		virtual ~SampleStore();
+
+		struct held_t
+		{
+			Sample* sample;
+			storage_t storage;
+			int references;
+		};
+
+		struct entry_t
+		{
+			std::string path;
+			std::vector<held_t> held;
+		};
+
+		static int find(const std::vector<held_t>& held, long frames, storage_t storage);
+
+		mutable boost::mutex _mutex;
+		bool _shared;
+		std::string _directory;
+		double _cache_limit;
+		std::deque<entry_t> _entries;
+		std::map<std::string, int> _ids;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_SAMPLESTORE_H
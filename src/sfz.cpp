@@ -20,7 +20,9 @@
 // Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #include "sfz.h"
+#include "samplestore.h"
 
+#include <cctype>
 #include <iostream>
 #include <sstream>
 
@@ -45,6 +47,33 @@ namespace sfz
 	{
 	}
 
+	/////////////////////////////////////////////////////////////
+	// struct flex_eg_t
+
+	flex_eg_t::flex_eg_t() :
+		sustain(-1),
+		amplitude(0),
+		volume(0),
+		pitch(0),
+		cutoff(0), cutoff2(0),
+		resonance(0), resonance2(0)
+	{
+	}
+
+	/////////////////////////////////////////////////////////////
+	// struct flex_lfo_t
+
+	flex_lfo_t::flex_lfo_t() :
+		freq(0),
+		delay(0),
+		fade(0),
+		phase(0),
+		wave(1)
+	{
+		for (int t = 0; t < LFO_TARGETS; ++t)
+			depth[t] = 0;
+	}
+
 	/////////////////////////////////////////////////////////////
 	// class Definition
 	
@@ -104,11 +133,11 @@ namespace sfz
  			rand    >= lorand     &&  rand    <= hirand     &&
 			timer   >= lotimer    &&  timer   <= hitimer    &&
  			seq == seq_position   &&
-			((sw_last >= sw_lokey && sw_last <= sw_hikey) ? (last_sw_key == sw_last) : true)  &&
-                        ((sw_down >= sw_lokey && sw_down <= sw_hikey) ? (sw[sw_down]) : true)  &&
-                        ((sw_up   >= sw_lokey && sw_up   <= sw_hikey) ? (!sw[sw_up])  : true)  &&
+			((sw_last >= 0 && sw_last >= sw_lokey && sw_last <= sw_hikey) ? (last_sw_key == sw_last) : true)  &&
+                        ((sw_down >= 0 && sw_down >= sw_lokey && sw_down <= sw_hikey) ? (sw[sw_down]) : true)  &&
+                        ((sw_up   >= 0 && sw_up   >= sw_lokey && sw_up   <= sw_hikey) ? (!sw[sw_up])  : true)  &&
 			((sw_previous != -1)                          ? (prev_sw_key == sw_previous) : true)  &&
- 			((trigger && trig) != 0)
+ 			((trigger & trig) != 0)
  			);
 
 		if (!is_triggered)
@@ -160,11 +189,11 @@ namespace sfz
  			rand    >= lorand           &&  rand    <= hirand             &&
 			timer   >= lotimer          &&  timer   <= hitimer            &&
  			seq == seq_position   &&
-			((sw_last >= sw_lokey && sw_last <= sw_hikey) ? (last_sw_key == sw_last) : true)  &&
-                        ((sw_down >= sw_lokey && sw_down <= sw_hikey) ? (sw[sw_down]) : true)  &&
-                        ((sw_up   >= sw_lokey && sw_up   <= sw_hikey) ? (!sw[sw_up])  : true)  &&
+			((sw_last >= 0 && sw_last >= sw_lokey && sw_last <= sw_hikey) ? (last_sw_key == sw_last) : true)  &&
+                        ((sw_down >= 0 && sw_down >= sw_lokey && sw_down <= sw_hikey) ? (sw[sw_down]) : true)  &&
+                        ((sw_up   >= 0 && sw_up   >= sw_lokey && sw_up   <= sw_hikey) ? (!sw[sw_up])  : true)  &&
 			((sw_previous != -1)                          ? (prev_sw_key == sw_previous) : true)  &&
- 			((trigger && trig) != 0)
+ 			((trigger & trig) != 0)
  			);
 
 		if (!is_triggered)
@@ -188,7 +217,8 @@ namespace sfz
 	/////////////////////////////////////////////////////////////
 	// class Instrument
 
-	Instrument::Instrument()
+	Instrument::Instrument() :
+		storage(STORAGE_FLOAT)
 	{
 	}
 
@@ -215,7 +245,7 @@ namespace sfz
 		// This is where all the default values are set.
 
 		// sample definition default
-		sample = "";
+		sample = -1;
 
 		// input control
 		lochan = 1; hichan = 16;
@@ -324,6 +354,91 @@ namespace sfz
 		eq2_vel2gain = 0;
 		eq3_vel2gain = 0;
 
+		// amplifier envelope generator
+		ampeg_delay = 0;
+		ampeg_start = 0;
+		ampeg_attack = 0;
+		ampeg_hold = 0;
+		ampeg_decay = 0;
+		ampeg_sustain = 100;
+		ampeg_release = 0;
+		ampeg_vel2delay = 0;
+		ampeg_vel2attack = 0;
+		ampeg_vel2hold = 0;
+		ampeg_vel2decay = 0;
+		ampeg_vel2sustain = 0;
+		ampeg_vel2release = 0;
+
+		// filter envelope generator
+		fileg_delay = 0;
+		fileg_start = 0;
+		fileg_attack = 0;
+		fileg_hold = 0;
+		fileg_decay = 0;
+		fileg_sustain = 0;
+		fileg_release = 0;
+		fileg_vel2delay = 0;
+		fileg_vel2attack = 0;
+		fileg_vel2hold = 0;
+		fileg_vel2decay = 0;
+		fileg_vel2sustain = 0;
+		fileg_vel2release = 0;
+		fileg_depth = 0;
+		fileg_vel2depth = 0;
+
+		// pitch envelope generator
+		pitcheg_delay = 0;
+		pitcheg_start = 0;
+		pitcheg_attack = 0;
+		pitcheg_hold = 0;
+		pitcheg_decay = 0;
+		pitcheg_sustain = 0;
+		pitcheg_release = 0;
+		pitcheg_vel2delay = 0;
+		pitcheg_vel2attack = 0;
+		pitcheg_vel2hold = 0;
+		pitcheg_vel2decay = 0;
+		pitcheg_vel2sustain = 0;
+		pitcheg_vel2release = 0;
+		pitcheg_depth = 0;
+		pitcheg_vel2depth = 0;
+
+		// flex envelope generators
+		eg.clear();
+
+		// amplifier lfo
+		amplfo_delay = 0;
+		amplfo_fade = 0;
+		amplfo_freq = 0;
+		amplfo_depth = 0;
+		amplfo_depthchanaft = 0;
+		amplfo_depthpolyaft = 0;
+		amplfo_freqchanaft = 0;
+		amplfo_freqpolyaft = 0;
+
+		// filter lfo
+		fillfo_delay = 0;
+		fillfo_fade = 0;
+		fillfo_freq = 0;
+		fillfo_depth = 0;
+		fillfo_depthchanaft = 0;
+		fillfo_depthpolyaft = 0;
+		fillfo_freqchanaft = 0;
+		fillfo_freqpolyaft = 0;
+
+		// pitch lfo
+		pitchlfo_delay = 0;
+		pitchlfo_fade = 0;
+		pitchlfo_freq = 0;
+		pitchlfo_depth = 0;
+		pitchlfo_depthchanaft = 0;
+		pitchlfo_depthpolyaft = 0;
+		pitchlfo_freqchanaft = 0;
+		pitchlfo_freqpolyaft = 0;
+
+		// flex lfos
+		lfo.clear();
+
 		// CCs
 		for (int i = 0; i < 128; ++i)
 		{
@@ -345,6 +460,9 @@ namespace sfz
 			// amplifier
 			amp_velcurve_[i] = 0; //fixme: 20 log (127^2 / i^2)
 			gain_oncc[i] = 0;
+			pan_oncc[i] = 0;
+			width_oncc[i] = 0;
+			position_oncc[i] = 0;
 			xfin_locc[i] = 0;
 			xfin_hicc[i] = 0;
 			xfout_locc[i] = 127;
@@ -379,6 +497,27 @@ namespace sfz
 			eq1_gain_oncc[i] = 0;
 			eq2_gain_oncc[i] = 0;
 			eq3_gain_oncc[i] = 0;
+
+			// amplifier envelope generator
+			ampeg_delaycc[i] = 0;
+			ampeg_startcc[i] = 0;
+			ampeg_attackcc[i] = 0;
+			ampeg_holdcc[i] = 0;
+			ampeg_decaycc[i] = 0;
+			ampeg_sustaincc[i] = 0;
+			ampeg_releasecc[i] = 0;
+
+			// amplifier lfo
+			amplfo_depthcc[i] = 0;
+			amplfo_freqcc[i] = 0;
+
+			// filter lfo
+			fillfo_depthcc[i] = 0;
+			fillfo_freqcc[i] = 0;
+
+			// pitch lfo
+			pitchlfo_depthcc[i] = 0;
+			pitchlfo_freqcc[i] = 0;
 		}
 	}
 
@@ -469,13 +608,16 @@ namespace sfz
 		region->amp_random = amp_random;
 		region->rt_decay = rt_decay;
 		region->gain_oncc = gain_oncc;
+		region->pan_oncc = pan_oncc;
+		region->width_oncc = width_oncc;
+		region->position_oncc = position_oncc;
 		region->xfin_lokey = xfin_lokey;
 		region->xfin_hikey = xfin_hikey;
 		region->xfout_lokey = xfout_lokey;
 		region->xfout_hikey = xfout_hikey;
 		region->xf_keycurve = xf_keycurve;
 		region->xfin_lovel = xfin_lovel;
-		region->xfin_hivel = xfin_lovel;
+		region->xfin_hivel = xfin_hivel;
 		region->xfout_lovel = xfout_lovel;
 		region->xfout_hivel = xfout_hivel;
 		region->xf_velcurve = xf_velcurve;
@@ -559,6 +701,104 @@ namespace sfz
 		region->eq2_vel2gain = eq2_vel2gain;
 		region->eq3_vel2gain = eq3_vel2gain;
 
+		// amplifier envelope generator
+		region->ampeg_delay = ampeg_delay;
+		region->ampeg_start = ampeg_start;
+		region->ampeg_attack = ampeg_attack;
+		region->ampeg_hold = ampeg_hold;
+		region->ampeg_decay = ampeg_decay;
+		region->ampeg_sustain = ampeg_sustain;
+		region->ampeg_release = ampeg_release;
+		region->ampeg_vel2delay = ampeg_vel2delay;
+		region->ampeg_vel2attack = ampeg_vel2attack;
+		region->ampeg_vel2hold = ampeg_vel2hold;
+		region->ampeg_vel2decay = ampeg_vel2decay;
+		region->ampeg_vel2sustain = ampeg_vel2sustain;
+		region->ampeg_vel2release = ampeg_vel2release;
+		region->ampeg_delaycc = ampeg_delaycc;
+		region->ampeg_startcc = ampeg_startcc;
+		region->ampeg_attackcc = ampeg_attackcc;
+		region->ampeg_holdcc = ampeg_holdcc;
+		region->ampeg_decaycc = ampeg_decaycc;
+		region->ampeg_sustaincc = ampeg_sustaincc;
+		region->ampeg_releasecc = ampeg_releasecc;
+
+		// filter envelope generator
+		region->fileg_delay = fileg_delay;
+		region->fileg_start = fileg_start;
+		region->fileg_attack = fileg_attack;
+		region->fileg_hold = fileg_hold;
+		region->fileg_decay = fileg_decay;
+		region->fileg_sustain = fileg_sustain;
+		region->fileg_release = fileg_release;
+		region->fileg_vel2delay = fileg_vel2delay;
+		region->fileg_vel2attack = fileg_vel2attack;
+		region->fileg_vel2hold = fileg_vel2hold;
+		region->fileg_vel2decay = fileg_vel2decay;
+		region->fileg_vel2sustain = fileg_vel2sustain;
+		region->fileg_vel2release = fileg_vel2release;
+		region->fileg_depth = fileg_depth;
+		region->fileg_vel2depth = fileg_vel2depth;
+
+		// pitch envelope generator
+		region->pitcheg_delay = pitcheg_delay;
+		region->pitcheg_start = pitcheg_start;
+		region->pitcheg_attack = pitcheg_attack;
+		region->pitcheg_hold = pitcheg_hold;
+		region->pitcheg_decay = pitcheg_decay;
+		region->pitcheg_sustain = pitcheg_sustain;
+		region->pitcheg_release = pitcheg_release;
+		region->pitcheg_vel2delay = pitcheg_vel2delay;
+		region->pitcheg_vel2attack = pitcheg_vel2attack;
+		region->pitcheg_vel2hold = pitcheg_vel2hold;
+		region->pitcheg_vel2decay = pitcheg_vel2decay;
+		region->pitcheg_vel2sustain = pitcheg_vel2sustain;
+		region->pitcheg_vel2release = pitcheg_vel2release;
+		region->pitcheg_depth = pitcheg_depth;
+		region->pitcheg_vel2depth = pitcheg_vel2depth;
+
+		// flex envelope generators
+		region->eg = eg;
+
+		// amplifier lfo
+		region->amplfo_delay = amplfo_delay;
+		region->amplfo_fade = amplfo_fade;
+		region->amplfo_freq = amplfo_freq;
+		region->amplfo_depth = amplfo_depth;
+		region->amplfo_depthchanaft = amplfo_depthchanaft;
+		region->amplfo_depthpolyaft = amplfo_depthpolyaft;
+		region->amplfo_freqchanaft = amplfo_freqchanaft;
+		region->amplfo_freqpolyaft = amplfo_freqpolyaft;
+		region->amplfo_depthcc = amplfo_depthcc;
+		region->amplfo_freqcc = amplfo_freqcc;
+
+		// filter lfo
+		region->fillfo_delay = fillfo_delay;
+		region->fillfo_fade = fillfo_fade;
+		region->fillfo_freq = fillfo_freq;
+		region->fillfo_depth = fillfo_depth;
+		region->fillfo_depthchanaft = fillfo_depthchanaft;
+		region->fillfo_depthpolyaft = fillfo_depthpolyaft;
+		region->fillfo_freqchanaft = fillfo_freqchanaft;
+		region->fillfo_freqpolyaft = fillfo_freqpolyaft;
+		region->fillfo_depthcc = fillfo_depthcc;
+		region->fillfo_freqcc = fillfo_freqcc;
+
+		// pitch lfo
+		region->pitchlfo_delay = pitchlfo_delay;
+		region->pitchlfo_fade = pitchlfo_fade;
+		region->pitchlfo_freq = pitchlfo_freq;
+		region->pitchlfo_depth = pitchlfo_depth;
+		region->pitchlfo_depthchanaft = pitchlfo_depthchanaft;
+		region->pitchlfo_depthpolyaft = pitchlfo_depthpolyaft;
+		region->pitchlfo_freqchanaft = pitchlfo_freqchanaft;
+		region->pitchlfo_freqpolyaft = pitchlfo_freqpolyaft;
+		region->pitchlfo_depthcc = pitchlfo_depthcc;
+		region->pitchlfo_freqcc = pitchlfo_freqcc;
+
+		// flex lfos
+		region->lfo = lfo;
+
 		return region;
 	}
 
@@ -568,6 +808,8 @@ namespace sfz
 	File::File(std::ifstream file) :
 		_instrument(new Instrument()),
 		_current_section(GROUP),
+		_current_region(0),
+		_current_group(new Group()),
 		default_path(""),
 		octave_offset(0),
 		note_offset(0)
@@ -655,6 +897,7 @@ namespace sfz
 
 	File::~File()
 	{
+		delete _current_group;
 	}
 
 	Instrument*
@@ -707,9 +950,10 @@ namespace sfz
 			switch (_current_section)
 			{
 			case REGION:
-				_current_region->sample = default_path + value;
+				_current_region->sample = SampleStore::Instance().Intern(default_path + value);
+				break;
 			case GROUP:
-				_current_group->sample = default_path + value;
+				_current_group->sample = SampleStore::Instance().Intern(default_path + value);
 			}
 			return;
 		}
@@ -750,6 +994,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lochan = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->lochan = boost::lexical_cast<int>(value);
 			}
@@ -761,6 +1006,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hichan = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hichan = boost::lexical_cast<int>(value);
 			}
@@ -772,6 +1018,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -783,6 +1030,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -795,6 +1043,7 @@ namespace sfz
 			case REGION:
 				_current_region->lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 				_current_region->hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 				_current_group->hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
@@ -807,6 +1056,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lovel = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->lovel = boost::lexical_cast<int>(value);
 			}
@@ -818,6 +1068,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hivel = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hivel = boost::lexical_cast<int>(value);
 			}
@@ -829,6 +1080,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lobend = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->lobend = boost::lexical_cast<int>(value);
 			}
@@ -840,6 +1092,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hibend = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hibend = boost::lexical_cast<int>(value);
 			}
@@ -851,6 +1104,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lobpm = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->lobpm = boost::lexical_cast<int>(value);
 			}
@@ -862,6 +1116,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hibpm = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hibpm = boost::lexical_cast<int>(value);
 			}
@@ -873,6 +1128,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lochanaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->lochanaft = boost::lexical_cast<int>(value);
 			}
@@ -884,6 +1140,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hichanaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hichanaft = boost::lexical_cast<int>(value);
 			}
@@ -895,6 +1152,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lopolyaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->lopolyaft = boost::lexical_cast<int>(value);
 			}
@@ -906,6 +1164,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hipolyaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hipolyaft = boost::lexical_cast<int>(value);
 			}
@@ -917,6 +1176,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->loprog = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->loprog = boost::lexical_cast<int>(value);
 			}
@@ -928,6 +1188,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hiprog = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->hiprog = boost::lexical_cast<int>(value);
 			}
@@ -939,6 +1200,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lorand = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->lorand = boost::lexical_cast<float>(value);
 			}
@@ -950,6 +1212,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hirand = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->hirand = boost::lexical_cast<float>(value);
 			}
@@ -961,6 +1224,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->lotimer = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->lotimer = boost::lexical_cast<float>(value);
 			}
@@ -972,6 +1236,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->hitimer = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->hitimer = boost::lexical_cast<float>(value);
 			}
@@ -983,6 +1248,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->seq_length = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->seq_length = boost::lexical_cast<int>(value);
 			}
@@ -994,6 +1260,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->seq_position = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->seq_position = boost::lexical_cast<int>(value);
 			}
@@ -1005,6 +1272,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sw_lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->sw_lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1016,6 +1284,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sw_hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->sw_hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1027,6 +1296,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sw_last = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->sw_last = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1038,6 +1308,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sw_down = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->sw_down = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1049,6 +1320,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sw_up = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->sw_up = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1060,6 +1332,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sw_previous = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->sw_previous = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1074,6 +1347,7 @@ namespace sfz
 					_current_region->sw_vel = VEL_CURRENT;
 				else if (value == "previous") 
 					_current_region->sw_vel = VEL_PREVIOUS;
+				break;
 			case GROUP:
 				if (value == "current") 
 					_current_group->sw_vel = VEL_CURRENT;
@@ -1095,6 +1369,7 @@ namespace sfz
 					_current_region->trigger = TRIGGER_FIRST;
 				else if (value == "legato") 
 					_current_region->trigger = TRIGGER_LEGATO;
+				break;
 			case GROUP:
 				if (value == "attack") 
 					_current_group->trigger = TRIGGER_ATTACK;
@@ -1113,6 +1388,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->group = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->group = boost::lexical_cast<int>(value);
 			}
@@ -1124,6 +1400,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->off_by = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->off_by = boost::lexical_cast<int>(value);
 			}
@@ -1138,6 +1415,7 @@ namespace sfz
 					_current_region->off_mode = OFF_FAST;
 				else if (value == "normal") 
 					_current_region->off_mode = OFF_NORMAL;
+				break;
 			case GROUP:
 				if (value == "fast") 
 					_current_group->off_mode = OFF_FAST;
@@ -1154,6 +1432,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->count = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->count = boost::lexical_cast<int>(value);
 			}
@@ -1165,6 +1444,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->delay = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->delay = boost::lexical_cast<float>(value);
 			}
@@ -1176,6 +1456,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->delay_random = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->delay_random = boost::lexical_cast<float>(value);
 			}
@@ -1187,6 +1468,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->delay_beats = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->delay_beats = boost::lexical_cast<int>(value);
 			}
@@ -1198,6 +1480,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->stop_beats = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->stop_beats = boost::lexical_cast<int>(value);
 			}
@@ -1209,6 +1492,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->delay_samples = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->delay_samples = boost::lexical_cast<int>(value);
 			}
@@ -1220,6 +1504,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->end = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->end = boost::lexical_cast<int>(value);
 			}
@@ -1231,17 +1516,31 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->loop_crossfade = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->loop_crossfade = boost::lexical_cast<float>(value);
 			}
 			return;
 		}
+		else if ("offset" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->offset = boost::lexical_cast<int>(value);
+				break;
+			case GROUP:
+				_current_group->offset = boost::lexical_cast<int>(value);
+			}
+			return;
+		}
 		else if ("offset_random" == key)
 		{
 			switch (_current_section)
 			{
 			case REGION:
 				_current_region->offset_random = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->offset_random = boost::lexical_cast<int>(value);
 			}
@@ -1260,6 +1559,7 @@ namespace sfz
 					_current_region->loop_mode = LOOP_CONTINOUS;
 				else if (value == "loop_sustain")
 					_current_region->loop_mode = LOOP_SUSTAIN;
+				break;
 			case GROUP:
 				if (value == "no_loop")
 					_current_group->loop_mode = NO_LOOP;
@@ -1278,6 +1578,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->loop_start = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->loop_start = boost::lexical_cast<int>(value);
 			}
@@ -1289,6 +1590,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->loop_end = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->loop_end = boost::lexical_cast<int>(value);
 			}
@@ -1300,6 +1602,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sync_beats = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->sync_beats = boost::lexical_cast<int>(value);
 			}
@@ -1311,6 +1614,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->sync_offset = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->sync_offset = boost::lexical_cast<int>(value);
 			}
@@ -1324,6 +1628,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->volume = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->volume = boost::lexical_cast<float>(value);
 			}
@@ -1335,6 +1640,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->pan = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->pan = boost::lexical_cast<float>(value);
 			}
@@ -1346,6 +1652,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->width = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->width = boost::lexical_cast<float>(value);
 			}
@@ -1357,6 +1664,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->position = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->position = boost::lexical_cast<float>(value);
 			}
@@ -1368,6 +1676,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->amp_keytrack = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->amp_keytrack = boost::lexical_cast<float>(value);
 			}
@@ -1379,6 +1688,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->amp_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->amp_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1390,6 +1700,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->amp_veltrack = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->amp_veltrack = boost::lexical_cast<float>(value);
 			}
@@ -1401,6 +1712,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->amp_random = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->amp_random = boost::lexical_cast<float>(value);
 			}
@@ -1412,6 +1724,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->rt_decay = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->rt_decay = boost::lexical_cast<float>(value);
 			}
@@ -1423,6 +1736,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfin_lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->xfin_lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1434,6 +1748,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfin_hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->xfin_hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1445,6 +1760,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfout_lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->xfout_lokey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1456,6 +1772,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfout_hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->xfout_hikey = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1470,6 +1787,7 @@ namespace sfz
 					_current_region->xf_keycurve = GAIN;
 				else if (value == "power")
 					_current_region->xf_keycurve = POWER;
+				break;
 			case GROUP:
 				if (value == "gain")
 					_current_group->xf_keycurve = GAIN;
@@ -1484,6 +1802,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfin_lovel = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->xfin_lovel = boost::lexical_cast<int>(value);
 			}
@@ -1495,6 +1814,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfin_hivel = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->xfin_hivel = boost::lexical_cast<int>(value);
 			}
@@ -1506,6 +1826,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfout_lovel = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->xfout_lovel = boost::lexical_cast<int>(value);
 			}
@@ -1517,6 +1838,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->xfout_hivel = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->xfout_hivel = boost::lexical_cast<int>(value);
 			}
@@ -1531,6 +1853,7 @@ namespace sfz
 					_current_region->xf_velcurve = GAIN;
 				else if (value == "power")
 					_current_region->xf_velcurve = POWER;
+				break;
 			case GROUP:
 				if (value == "gain")
 					_current_group->xf_velcurve = GAIN;
@@ -1548,6 +1871,7 @@ namespace sfz
 					_current_region->xf_cccurve = GAIN;
 				else if (value == "power")
 					_current_region->xf_cccurve = POWER;
+				break;
 			case GROUP:
 				if (value == "gain")
 					_current_group->xf_cccurve = GAIN;
@@ -1564,6 +1888,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->transpose = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->transpose = boost::lexical_cast<int>(value);
 			}
@@ -1575,6 +1900,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->tune = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->tune = boost::lexical_cast<int>(value);
 			}
@@ -1586,6 +1912,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->pitch_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->pitch_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1597,6 +1924,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->pitch_keytrack = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->pitch_keytrack = boost::lexical_cast<int>(value);
 			}
@@ -1608,6 +1936,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->pitch_veltrack = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->pitch_veltrack = boost::lexical_cast<int>(value);
 			}
@@ -1619,6 +1948,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->pitch_random = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->pitch_random = boost::lexical_cast<int>(value);
 			}
@@ -1630,6 +1960,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->bend_up = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->bend_up = boost::lexical_cast<int>(value);
 			}
@@ -1641,6 +1972,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->bend_down = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->bend_down = boost::lexical_cast<int>(value);
 			}
@@ -1652,6 +1984,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->bend_step = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->bend_step = boost::lexical_cast<int>(value);
 			}
@@ -1692,6 +2025,7 @@ namespace sfz
 					_current_region->fil_type = LPF_6P;
 				else if (value == "hpf_6p")
 					_current_region->fil_type = HPF_6P;
+				break;
 			case GROUP:
 				if (value == "lpf_1p")
 					_current_group->fil_type = LPF_1P;
@@ -1757,6 +2091,7 @@ namespace sfz
 					_current_region->fil2_type = LPF_6P;
 				else if (value == "hpf_6p")
 					_current_region->fil2_type = HPF_6P;
+				break;
 			case GROUP:
 				if (value == "lpf_1p")
 					_current_group->fil2_type = LPF_1P;
@@ -1795,6 +2130,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->cutoff = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->cutoff = boost::lexical_cast<float>(value);
 			}
@@ -1806,6 +2142,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->cutoff2 = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->cutoff2 = boost::lexical_cast<float>(value);
 			}
@@ -1817,6 +2154,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->cutoff_chanaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->cutoff_chanaft = boost::lexical_cast<int>(value);
 			}
@@ -1828,6 +2166,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->cutoff2_chanaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->cutoff2_chanaft = boost::lexical_cast<int>(value);
 			}
@@ -1839,6 +2178,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->cutoff_polyaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->cutoff_polyaft = boost::lexical_cast<int>(value);
 			}
@@ -1850,6 +2190,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->cutoff2_polyaft = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->cutoff2_polyaft = boost::lexical_cast<int>(value);
 			}
@@ -1861,6 +2202,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->resonance = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->resonance = boost::lexical_cast<float>(value);
 			}
@@ -1872,6 +2214,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->resonance2 = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->resonance2 = boost::lexical_cast<float>(value);
 			}
@@ -1883,6 +2226,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil_keytrack = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->fil_keytrack = boost::lexical_cast<int>(value);
 			}
@@ -1894,6 +2238,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil2_keytrack = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->fil2_keytrack = boost::lexical_cast<int>(value);
 			}
@@ -1905,6 +2250,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->fil_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1916,6 +2262,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil2_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
+				break;
 			case GROUP:
 				_current_group->fil2_keycenter = boost::lexical_cast<int>(value) + note_offset + 12 * octave_offset;
 			}
@@ -1927,6 +2274,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil_veltrack = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->fil_veltrack = boost::lexical_cast<int>(value);
 			}
@@ -1938,6 +2286,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil2_veltrack = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->fil2_veltrack = boost::lexical_cast<int>(value);
 			}
@@ -1949,6 +2298,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil_random = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->fil_random = boost::lexical_cast<int>(value);
 			}
@@ -1960,6 +2310,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->fil2_random = boost::lexical_cast<int>(value);
+				break;
 			case GROUP:
 				_current_group->fil2_random = boost::lexical_cast<int>(value);
 			}
@@ -1973,6 +2324,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq1_freq = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq1_freq = boost::lexical_cast<float>(value);
 			}
@@ -1984,6 +2336,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq2_freq = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq2_freq = boost::lexical_cast<float>(value);
 			}
@@ -1995,6 +2348,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq3_freq = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq3_freq = boost::lexical_cast<float>(value);
 			}
@@ -2006,6 +2360,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq1_vel2freq = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq1_vel2freq = boost::lexical_cast<float>(value);
 			}
@@ -2017,6 +2372,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq2_vel2freq = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq2_vel2freq = boost::lexical_cast<float>(value);
 			}
@@ -2028,6 +2384,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq3_vel2freq = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq3_vel2freq = boost::lexical_cast<float>(value);
 			}
@@ -2039,6 +2396,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq1_bw = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq1_bw = boost::lexical_cast<float>(value);
 			}
@@ -2050,6 +2408,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq2_bw = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq2_bw = boost::lexical_cast<float>(value);
 			}
@@ -2061,6 +2420,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq3_bw = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq3_bw = boost::lexical_cast<float>(value);
 			}
@@ -2072,6 +2432,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq1_gain = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq1_gain = boost::lexical_cast<float>(value);
 			}
@@ -2083,6 +2444,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq2_gain = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq2_gain = boost::lexical_cast<float>(value);
 			}
@@ -2094,6 +2456,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq3_gain = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq3_gain = boost::lexical_cast<float>(value);
 			}
@@ -2105,6 +2468,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq1_vel2gain = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq1_vel2gain = boost::lexical_cast<float>(value);
 			}
@@ -2116,6 +2480,7 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq2_vel2gain = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq2_vel2gain = boost::lexical_cast<float>(value);
 			}
@@ -2127,178 +2492,1073 @@ namespace sfz
 			{
 			case REGION:
 				_current_region->eq3_vel2gain = boost::lexical_cast<float>(value);
+				break;
 			case GROUP:
 				_current_group->eq3_vel2gain = boost::lexical_cast<float>(value);
 			}
 			return;
 		}
 
-		//fixme: parse amp_velcurve_N
-
-		// CCs
-		else
+		// amplifier envelope generator
+		else if ("ampeg_delay" == key)
 		{
-			std::string::size_type delimiter_index = key.find("cc");
-			std::string key_cc = key.substr(0, delimiter_index);
-			int num_cc = boost::lexical_cast<int>(key.substr(delimiter_index + 2));
-
-			// input controls
-			if ("lo" == key_cc)
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->locc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->locc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_delay = boost::lexical_cast<float>(value);
 			}
-			else if ("hi" == key_cc)
+			return;
+		}
+		else if ("ampeg_start" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->hicc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->hicc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_start = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_start = boost::lexical_cast<float>(value);
 			}
-			else if ("start_lo" == key_cc)
+			return;
+		}
+		else if ("ampeg_attack" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->start_locc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->start_locc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_attack = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_attack = boost::lexical_cast<float>(value);
 			}
-			else if ("start_hi" == key_cc)
+			return;
+		}
+		else if ("ampeg_hold" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->start_hicc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->start_hicc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_hold = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_hold = boost::lexical_cast<float>(value);
 			}
-			else if ("stop_lo" == key_cc)
+			return;
+		}
+		else if ("ampeg_decay" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->stop_locc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->stop_locc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_decay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_decay = boost::lexical_cast<float>(value);
 			}
-			else if ("stop_hi" == key_cc)
+			return;
+		}
+		else if ("ampeg_sustain" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->stop_hicc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->stop_hicc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_sustain = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_sustain = boost::lexical_cast<float>(value);
 			}
-			else if ("on_lo" == key_cc)
+			return;
+		}
+		else if ("ampeg_release" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->on_locc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->on_locc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_release = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_release = boost::lexical_cast<float>(value);
 			}
-			else if ("on_hi" == key_cc)
+			return;
+		}
+		else if ("ampeg_vel2delay" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->on_hicc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->on_hicc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_vel2delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_vel2delay = boost::lexical_cast<float>(value);
 			}
-
-			// sample player
-			else if ("delay_on" == key_cc)
+			return;
+		}
+		else if ("ampeg_vel2attack" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->delay_oncc[num_cc] = boost::lexical_cast<float>(value);
-				case GROUP:
-					_current_group->delay_oncc[num_cc] = boost::lexical_cast<float>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_vel2attack = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_vel2attack = boost::lexical_cast<float>(value);
 			}
-			else if ("delay_samples_on" == key_cc)
+			return;
+		}
+		else if ("ampeg_vel2hold" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->delay_samples_oncc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->delay_samples_oncc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_vel2hold = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_vel2hold = boost::lexical_cast<float>(value);
 			}
-			else if ("offset_on" == key_cc)
+			return;
+		}
+		else if ("ampeg_vel2decay" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->offset_oncc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->offset_oncc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_vel2decay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_vel2decay = boost::lexical_cast<float>(value);
 			}
-
-			// amplifier
-			else if ("gain_on" == key_cc)
+			return;
+		}
+		else if ("ampeg_vel2sustain" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->gain_oncc[num_cc] = boost::lexical_cast<float>(value);
-				case GROUP:
-					_current_group->gain_oncc[num_cc] = boost::lexical_cast<float>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_vel2sustain = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_vel2sustain = boost::lexical_cast<float>(value);
 			}
-			else if ("xfin_lo" == key_cc)
+			return;
+		}
+		else if ("ampeg_vel2release" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->xfin_locc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->xfin_locc[num_cc] = boost::lexical_cast<int>(value);
-				}
-				return;
+			case REGION:
+				_current_region->ampeg_vel2release = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->ampeg_vel2release = boost::lexical_cast<float>(value);
 			}
-			else if ("xfin_hi" == key_cc)
+			return;
+		}
+
+		// filter envelope generator
+		else if ("fileg_delay" == key)
+		{
+			switch (_current_section)
 			{
-				switch (_current_section)
-				{
-				case REGION:
-					_current_region->xfin_hicc[num_cc] = boost::lexical_cast<int>(value);
-				case GROUP:
-					_current_group->xfin_hicc[num_cc] = boost::lexical_cast<int>(value);
-				}
+			case REGION:
+				_current_region->fileg_delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_start" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_start = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_start = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_attack" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_attack = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_attack = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_hold" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_hold = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_hold = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_decay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_decay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_decay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_sustain" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_sustain = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_sustain = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_release" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_release = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_release = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2delay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2attack" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2attack = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2attack = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2hold" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2hold = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2hold = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2decay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2decay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2decay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2sustain" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2sustain = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2sustain = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2release" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2release = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2release = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fileg_vel2depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fileg_vel2depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fileg_vel2depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+
+		// pitch envelope generator
+		else if ("pitcheg_delay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_start" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_start = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_start = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_attack" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_attack = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_attack = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_hold" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_hold = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_hold = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_decay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_decay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_decay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_sustain" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_sustain = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_sustain = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_release" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_release = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_release = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2delay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2attack" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2attack = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2attack = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2hold" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2hold = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2hold = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2decay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2decay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2decay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2sustain" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2sustain = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2sustain = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2release" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2release = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2release = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitcheg_vel2depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitcheg_vel2depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitcheg_vel2depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+
+		// flex envelope generators
+		else if (0 == key.compare(0, 2, "eg") && key.size() > 2 && std::isdigit(key[2]))
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				push_eg(_current_region, key, value);
+				break;
+			case GROUP:
+				push_eg(_current_group, key, value);
+			}
+			return;
+		}
+
+		// amplifier lfo
+		else if ("amplfo_delay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_fade" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_fade = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_fade = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_freq" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_freq = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_freq = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_depthchanaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_depthchanaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_depthchanaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_depthpolyaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_depthpolyaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_depthpolyaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_freqchanaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_freqchanaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_freqchanaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("amplfo_freqpolyaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->amplfo_freqpolyaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->amplfo_freqpolyaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+
+		// filter lfo
+		else if ("fillfo_delay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_fade" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_fade = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_fade = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_freq" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_freq = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_freq = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_depthchanaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_depthchanaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_depthchanaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_depthpolyaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_depthpolyaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_depthpolyaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_freqchanaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_freqchanaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_freqchanaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("fillfo_freqpolyaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->fillfo_freqpolyaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->fillfo_freqpolyaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+
+		// pitch lfo
+		else if ("pitchlfo_delay" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_delay = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_delay = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_fade" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_fade = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_fade = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_freq" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_freq = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_freq = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_depth" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_depth = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_depth = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_depthchanaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_depthchanaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_depthchanaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_depthpolyaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_depthpolyaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_depthpolyaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_freqchanaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_freqchanaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_freqchanaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+		else if ("pitchlfo_freqpolyaft" == key)
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				_current_region->pitchlfo_freqpolyaft = boost::lexical_cast<float>(value);
+				break;
+			case GROUP:
+				_current_group->pitchlfo_freqpolyaft = boost::lexical_cast<float>(value);
+			}
+			return;
+		}
+
+		// flex lfos
+		else if (0 == key.compare(0, 3, "lfo") && key.size() > 3 && std::isdigit(key[3]))
+		{
+			switch (_current_section)
+			{
+			case REGION:
+				push_lfo(_current_region, key, value);
+				break;
+			case GROUP:
+				push_lfo(_current_group, key, value);
+			}
+			return;
+		}
+
+		//fixme: parse amp_velcurve_N
+
+		// CCs
+		else
+		{
+			std::string::size_type delimiter_index = key.find("cc");
+			std::string key_cc = key.substr(0, delimiter_index);
+			int num_cc = boost::lexical_cast<int>(key.substr(delimiter_index + 2));
+
+			// input controls
+			if ("lo" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->locc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->locc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("hi" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->hicc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->hicc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("start_lo" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->start_locc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->start_locc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("start_hi" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->start_hicc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->start_hicc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("stop_lo" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->stop_locc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->stop_locc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("stop_hi" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->stop_hicc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->stop_hicc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("on_lo" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->on_locc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->on_locc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("on_hi" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->on_hicc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->on_hicc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+
+			// sample player
+			else if ("delay_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->delay_oncc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->delay_oncc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("delay_samples_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->delay_samples_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->delay_samples_oncc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("offset_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->offset_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->offset_oncc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+
+			// amplifier
+			else if ("gain_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->gain_oncc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->gain_oncc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("pan_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->pan_oncc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->pan_oncc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("width_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->width_oncc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->width_oncc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("position_on" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->position_oncc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->position_oncc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("xfin_lo" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->xfin_locc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->xfin_locc[num_cc] = boost::lexical_cast<int>(value);
+				}
+				return;
+			}
+			else if ("xfin_hi" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->xfin_hicc[num_cc] = boost::lexical_cast<int>(value);
+					break;
+				case GROUP:
+					_current_group->xfin_hicc[num_cc] = boost::lexical_cast<int>(value);
+				}
 				return;
 			}
 			else if ("xfout_lo" == key_cc)
@@ -2307,6 +3567,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->xfout_locc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->xfout_locc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2318,6 +3579,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->xfout_hicc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->xfout_hicc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2331,6 +3593,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2342,6 +3605,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff2_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff2_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2353,6 +3617,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff_smoothcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff_smoothcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2364,6 +3629,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff2_smoothcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff2_smoothcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2375,6 +3641,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff_stepcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff_stepcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2386,6 +3653,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff2_stepcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff2_stepcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2397,6 +3665,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff_curvecc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff_curvecc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2408,6 +3677,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->cutoff2_curvecc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->cutoff2_curvecc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2419,6 +3689,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2430,6 +3701,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance2_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance2_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2441,6 +3713,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance_smoothcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance_smoothcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2452,6 +3725,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance2_smoothcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance2_smoothcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2463,6 +3737,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance_stepcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance_stepcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2474,6 +3749,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance2_stepcc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance2_stepcc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2485,6 +3761,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance_curvecc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance_curvecc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2496,6 +3773,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->resonance2_curvecc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->resonance2_curvecc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2509,6 +3787,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq1_freq_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq1_freq_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2520,6 +3799,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq2_freq_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq2_freq_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2531,6 +3811,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq3_freq_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq3_freq_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2542,6 +3823,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq1_bw_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq1_bw_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2553,6 +3835,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq2_bw_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq2_bw_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2564,6 +3847,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq3_bw_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq3_bw_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2575,6 +3859,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq1_gain_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq1_gain_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2586,6 +3871,7 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq2_gain_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq2_gain_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
@@ -2597,15 +3883,333 @@ namespace sfz
 				{
 				case REGION:
 					_current_region->eq3_gain_oncc[num_cc] = boost::lexical_cast<int>(value);
+					break;
 				case GROUP:
 					_current_group->eq3_gain_oncc[num_cc] = boost::lexical_cast<int>(value);
 				}
 				return;
 			}
+
+			// amplifier envelope generator
+			else if ("ampeg_delay" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_delaycc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_delaycc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("ampeg_start" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_startcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_startcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("ampeg_attack" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_attackcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_attackcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("ampeg_hold" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_holdcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_holdcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("ampeg_decay" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_decaycc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_decaycc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("ampeg_sustain" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_sustaincc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_sustaincc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("ampeg_release" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->ampeg_releasecc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->ampeg_releasecc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+
+			// amplifier lfo
+			else if ("amplfo_depth" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->amplfo_depthcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->amplfo_depthcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("amplfo_freq" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->amplfo_freqcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->amplfo_freqcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+
+			// filter lfo
+			else if ("fillfo_depth" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->fillfo_depthcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->fillfo_depthcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("fillfo_freq" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->fillfo_freqcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->fillfo_freqcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+
+			// pitch lfo
+			else if ("pitchlfo_depth" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->pitchlfo_depthcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->pitchlfo_depthcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
+			else if ("pitchlfo_freq" == key_cc)
+			{
+				switch (_current_section)
+				{
+				case REGION:
+					_current_region->pitchlfo_freqcc[num_cc] = boost::lexical_cast<float>(value);
+					break;
+				case GROUP:
+					_current_group->pitchlfo_freqcc[num_cc] = boost::lexical_cast<float>(value);
+				}
+				return;
+			}
 		}
 
 		std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
 	}
-	
+
+	void
+	File::push_eg(Definition* definition, std::string key, std::string value)
+	{
+		// egN_<parameter>[X]
+		std::string::size_type delimiter_index = key.find('_');
+		if (delimiter_index == std::string::npos)
+		{
+			std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+			return;
+		}
+		int num_eg = boost::lexical_cast<int>(key.substr(2, delimiter_index - 2));
+		std::string parameter = key.substr(delimiter_index + 1);
+		if (num_eg < 1 || num_eg > MAX_FLEX_EGS)
+		{
+			std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+			return;
+		}
+
+		if (definition->eg.size() < (size_t) num_eg)
+			definition->eg.resize(num_eg);
+		flex_eg_t& eg = definition->eg[num_eg - 1];
+
+		// targets
+		if ("sustain" == parameter)
+			eg.sustain = boost::lexical_cast<int>(value);
+		else if ("amplitude" == parameter)
+			eg.amplitude = boost::lexical_cast<float>(value);
+		else if ("volume" == parameter)
+			eg.volume = boost::lexical_cast<float>(value);
+		else if ("pitch" == parameter)
+			eg.pitch = boost::lexical_cast<float>(value);
+		else if ("cutoff" == parameter)
+			eg.cutoff = boost::lexical_cast<float>(value);
+		else if ("cutoff2" == parameter)
+			eg.cutoff2 = boost::lexical_cast<float>(value);
+		else if ("resonance" == parameter)
+			eg.resonance = boost::lexical_cast<float>(value);
+		else if ("resonance2" == parameter)
+			eg.resonance2 = boost::lexical_cast<float>(value);
+
+		// points
+		else
+		{
+			std::string::size_type point_index = parameter.find_first_of("0123456789");
+			std::string name = parameter.substr(0, point_index);
+			if (point_index == std::string::npos || ("time" != name && "level" != name && "shape" != name))
+			{
+				std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+				return;
+			}
+
+			int num_point = boost::lexical_cast<int>(parameter.substr(point_index));
+			if (num_point < 0 || num_point >= MAX_FLEX_EG_POINTS)
+			{
+				std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+				return;
+			}
+			if (eg.points.size() < (size_t) num_point + 1)
+			{
+				eg_point_t point = { 0, 0, 0 };
+				eg.points.resize(num_point + 1, point);
+			}
+			eg_point_t& point = eg.points[num_point];
+
+			if ("time" == name)
+				point.time = boost::lexical_cast<float>(value);
+			else if ("level" == name)
+				point.level = boost::lexical_cast<float>(value);
+			else
+				point.shape = boost::lexical_cast<float>(value);
+		}
+	}
+
+	void
+	File::push_lfo(Definition* definition, std::string key, std::string value)
+	{
+		// lfoN_<parameter>[_onccX]
+		std::string::size_type delimiter_index = key.find('_');
+		if (delimiter_index == std::string::npos)
+		{
+			std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+			return;
+		}
+		int num_lfo = boost::lexical_cast<int>(key.substr(3, delimiter_index - 3));
+		std::string parameter = key.substr(delimiter_index + 1);
+		if (num_lfo < 1 || num_lfo > MAX_FLEX_LFOS)
+		{
+			std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+			return;
+		}
+
+		int num_cc = -1;
+		std::string::size_type cc_index = parameter.find("_oncc");
+		if (cc_index != std::string::npos)
+		{
+			num_cc = boost::lexical_cast<int>(parameter.substr(cc_index + 5));
+			parameter = parameter.substr(0, cc_index);
+			if (num_cc < 0 || num_cc > 127)
+				return;
+		}
+
+		if (definition->lfo.size() < (size_t) num_lfo)
+			definition->lfo.resize(num_lfo);
+		flex_lfo_t& lfo = definition->lfo[num_lfo - 1];
+
+		static const char* targets[LFO_TARGETS] = {
+			"amplitude", "volume", "pitch", "cutoff", "cutoff2", "resonance", "resonance2"
+		};
+		for (int t = 0; t < LFO_TARGETS; ++t)
+		{
+			if (parameter != targets[t])
+				continue;
+			if (num_cc < 0)
+				lfo.depth[t] = boost::lexical_cast<float>(value);
+			else
+				set_lfo_cc(lfo.depthcc[t], num_cc, boost::lexical_cast<float>(value));
+			return;
+		}
+
+		if ("freq" == parameter && num_cc >= 0)
+			set_lfo_cc(lfo.freqcc, num_cc, boost::lexical_cast<float>(value));
+		else if (num_cc >= 0)
+			std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+		else if ("freq" == parameter)
+			lfo.freq = boost::lexical_cast<float>(value);
+		else if ("delay" == parameter)
+			lfo.delay = boost::lexical_cast<float>(value);
+		else if ("fade" == parameter)
+			lfo.fade = boost::lexical_cast<float>(value);
+		else if ("phase" == parameter)
+			lfo.phase = boost::lexical_cast<float>(value);
+		else if ("wave" == parameter)
+			lfo.wave = boost::lexical_cast<int>(value);
+		else
+			std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+	}
+
+	void
+	File::set_lfo_cc(std::vector<lfo_cc_t>& ccs, int cc, float depth)
+	{
+		// a repeated onccX (e.g. a region overriding its group) replaces
+		// the earlier depth instead of adding a second one
+		for (size_t i = 0; i < ccs.size(); ++i)
+		{
+			if (ccs[i].cc == cc)
+			{
+				ccs[i].depth = depth;
+				return;
+			}
+		}
+		lfo_cc_t entry = { cc, depth };
+		ccs.push_back(entry);
+	}
 
 } // !namespace sfz
@@ -53,6 +53,7 @@ namespace sfz
 			   LPF_2P, HPF_2P, BPF_2P, BRF_2P, PKF_2P, 
 			   LPF_4P, HPF_4P, 
 			   LPF_6P, HPF_6P };
+	enum storage_t   { STORAGE_FLOAT, STORAGE_COMPACT };
 
 	typedef unsigned char trigger_t;
 	typedef unsigned char uint8_t;
@@ -139,11 +140,10 @@ namespace sfz
 			initialized = false;
 		}
 		
-		optional& operator =(const optional& arg) throw (Exception) 
+		optional& operator =(const optional& arg) 
 		{
-			if (!arg.initialized) throw Exception("optional variable not initialized");
-			this->data  = arg.data;
-			initialized = true;
+			if (arg.initialized) this->data = arg.data;
+			initialized = arg.initialized;
 			return *this;
 		}
 		
@@ -188,6 +188,73 @@ namespace sfz
 		virtual ~Articulation();
 	};
 
+	/////////////////////////////////////////////////////////////
+	// struct flex_eg_t
+
+	/// Flex envelopes a definition holds (eg1..eg4) and the points of
+	/// each (0..15, one Envelope segment apiece), higher N are ignored
+	enum { MAX_FLEX_EGS = 4, MAX_FLEX_EG_POINTS = 16 };
+
+	/// A point of a flex envelope (egN_timeX, egN_levelX, egN_shapeX)
+	struct eg_point_t
+	{
+		float time;
+		float level;
+		float shape;
+	};
+
+	/// A flex envelope (egN_*) and the depth it applies to each target
+	struct flex_eg_t
+	{
+		flex_eg_t();
+
+		std::vector<eg_point_t> points;
+		int sustain;
+
+		float amplitude;
+		float volume;
+		float pitch;
+		float cutoff; float cutoff2;
+		float resonance; float resonance2;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// struct flex_lfo_t
+
+	// Targets of a flex lfo (lfoN_<target>), in target units
+	enum lfo_target_t { LFO_AMPLITUDE,                   // %
+			    LFO_VOLUME,                      // dB
+			    LFO_PITCH,                       // cents
+			    LFO_CUTOFF, LFO_CUTOFF2,         // cents
+			    LFO_RESONANCE, LFO_RESONANCE2,   // dB
+			    LFO_TARGETS };
+
+	/// Depth added by a controller (lfoN_<target>_onccX, lfoN_freq_onccX)
+	struct lfo_cc_t
+	{
+		int cc;
+		float depth;
+	};
+
+	/// Flex lfos a definition holds (lfo1..lfo4), higher N are ignored
+	enum { MAX_FLEX_LFOS = 4 };
+
+	/// A flex lfo (lfoN_*)
+	struct flex_lfo_t
+	{
+		flex_lfo_t();
+
+		float freq;
+		float delay;
+		float fade;
+		float phase;
+		int wave;
+
+		float depth[LFO_TARGETS];
+		std::vector<lfo_cc_t> depthcc[LFO_TARGETS];
+		std::vector<lfo_cc_t> freqcc;
+	};
+
 	/////////////////////////////////////////////////////////////
 	// class Definition
 
@@ -198,8 +265,8 @@ namespace sfz
 		Definition();
 		virtual ~Definition();
 
-		// sample definition
-		std::string sample;
+		// sample definition, the id of the file in the SampleStore or -1
+		int sample;
 
 		// input controls
 		int   lochan;    int   hichan;
@@ -256,6 +323,7 @@ namespace sfz
 		float amp_keytrack; int amp_keycenter; float amp_veltrack; boost::array<float, 128> amp_velcurve_; float amp_random;
 		float rt_decay;
 		boost::array<float, 128> gain_oncc;
+		boost::array<float, 128> pan_oncc; boost::array<float, 128> width_oncc; boost::array<float, 128> position_oncc;
 		int xfin_lokey; int xfin_hikey;
 		int xfout_lokey; int xfout_hikey;
 		curve_t xf_keycurve;
@@ -300,6 +368,42 @@ namespace sfz
 		float eq1_gain; float eq2_gain; float eq3_gain;
 		boost::array<float, 128> eq1_gain_oncc; boost::array<float, 128> eq2_gain_oncc; boost::array<float, 128> eq3_gain_oncc;
 		float eq1_vel2gain; float eq2_vel2gain; float eq3_vel2gain;
+
+		// amplifier envelope generator
+		float ampeg_delay; float ampeg_start; float ampeg_attack; float ampeg_hold; float ampeg_decay; float ampeg_sustain; float ampeg_release;
+		float ampeg_vel2delay; float ampeg_vel2attack; float ampeg_vel2hold; float ampeg_vel2decay; float ampeg_vel2sustain; float ampeg_vel2release;
+		boost::array<float, 128> ampeg_delaycc; boost::array<float, 128> ampeg_startcc; boost::array<float, 128> ampeg_attackcc; boost::array<float, 128> ampeg_holdcc; boost::array<float, 128> ampeg_decaycc; boost::array<float, 128> ampeg_sustaincc; boost::array<float, 128> ampeg_releasecc;
+
+		// filter envelope generator
+		float fileg_delay; float fileg_start; float fileg_attack; float fileg_hold; float fileg_decay; float fileg_sustain; float fileg_release;
+		float fileg_vel2delay; float fileg_vel2attack; float fileg_vel2hold; float fileg_vel2decay; float fileg_vel2sustain; float fileg_vel2release;
+		float fileg_depth; float fileg_vel2depth;
+
+		// pitch envelope generator
+		float pitcheg_delay; float pitcheg_start; float pitcheg_attack; float pitcheg_hold; float pitcheg_decay; float pitcheg_sustain; float pitcheg_release;
+		float pitcheg_vel2delay; float pitcheg_vel2attack; float pitcheg_vel2hold; float pitcheg_vel2decay; float pitcheg_vel2sustain; float pitcheg_vel2release;
+		float pitcheg_depth; float pitcheg_vel2depth;
+
+		// flex envelope generators, eg[N - 1] holds egN_*
+		std::vector<flex_eg_t> eg;
+
+		// amplifier lfo
+		float amplfo_delay; float amplfo_fade; float amplfo_freq; float amplfo_depth;
+		boost::array<float, 128> amplfo_depthcc; float amplfo_depthchanaft; float amplfo_depthpolyaft;
+		boost::array<float, 128> amplfo_freqcc; float amplfo_freqchanaft; float amplfo_freqpolyaft;
+
+		// filter lfo
+		float fillfo_delay; float fillfo_fade; float fillfo_freq; float fillfo_depth;
+		boost::array<float, 128> fillfo_depthcc; float fillfo_depthchanaft; float fillfo_depthpolyaft;
+		boost::array<float, 128> fillfo_freqcc; float fillfo_freqchanaft; float fillfo_freqpolyaft;
+
+		// pitch lfo
+		float pitchlfo_delay; float pitchlfo_fade; float pitchlfo_freq; float pitchlfo_depth;
+		boost::array<float, 128> pitchlfo_depthcc; float pitchlfo_depthchanaft; float pitchlfo_depthpolyaft;
+		boost::array<float, 128> pitchlfo_freqcc; float pitchlfo_freqchanaft; float pitchlfo_freqpolyaft;
+
+		// flex lfos, lfo[N - 1] holds lfoN_*
+		std::vector<flex_lfo_t> lfo;
 	};
 	
 	/////////////////////////////////////////////////////////////
@@ -344,6 +448,11 @@ namespace sfz
 
 		/// List of Regions belonging to this Instrument
 		std::vector<Region*> regions;
+
+		/// How the audio of the samples is kept in memory, compact
+		/// storage keeps integer PCM as 16 or 24 bit words and decodes
+		/// it while playing; set by the host before loading samples
+		storage_t storage;
 	};
 
 	/////////////////////////////////////////////////////////////
@@ -385,6 +494,9 @@ namespace sfz
 	private:
 		void push_header(std::string token);
 		void push_opcode(std::string token);
+		void push_eg(Definition* definition, std::string key, std::string value);
+		void push_lfo(Definition* definition, std::string key, std::string value);
+		static void set_lfo_cc(std::vector<lfo_cc_t>& ccs, int cc, float depth);
 
 		/// Pointer to the Instrument belonging to this file
 		Instrument* _instrument;
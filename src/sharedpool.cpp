@@ -0,0 +1,280 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <sstream>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "sharedpool.h"
+#include "samplestore.h"
+
+namespace sfz
+{
+
+	namespace ipc = boost::interprocess;
+
+	// first page of a segment, the key follows and the frames start on
+	// the next page
+	struct segment_t
+	{
+		char magic[8];
+		boost::atomic<boost::uint32_t> ready;   // 0 decoding, 1 ready, 2 failed
+		boost::atomic<boost::uint32_t> users;   // 0 once the last user left
+		boost::int32_t creator;                 // pid of the decoding process
+		boost::int32_t channels;
+		boost::int32_t format;
+		boost::int64_t frames;
+		boost::int64_t preloaded;
+		boost::int64_t loop_start;
+		boost::int64_t loop_end;
+		float rate;
+		boost::uint32_t key_length;
+	};
+
+	// the key bytes right after the header, addressed as raw memory since
+	// segment_t holds atomics and is not trivially copyable
+	static char* segment_key(segment_t* segment)
+	{
+		return reinterpret_cast<char*>(segment + 1);
+	}
+
+	static const char MAGIC[8] = { 'l', 'i', 'b', 's', 'f', 'z', 'S', '3' };
+
+	// the mappings of a segment, handed to the Sample as its owner
+	struct mapping_t
+	{
+		mapping_t() : counted(false) {}
+		~mapping_t()
+		{
+			segment_t* segment = (segment_t*) header.get_address();
+			if (counted && segment->users.fetch_sub(1) == 1)
+				ipc::shared_memory_object::remove(name.c_str());
+		}
+
+		std::string name;
+		ipc::mapped_region header;
+		ipc::mapped_region frames;
+		bool counted;
+	};
+
+	// whether the process decoding segment is gone, it then never
+	// finishes and the segment has to be failed by a waiter
+	static bool
+	creator_died(const segment_t* segment)
+	{
+		return segment->creator > 0 && ::kill(segment->creator, 0) != 0 && errno == ESRCH;
+	}
+
+	// count one more user unless the last one already left, its name is
+	// then about to be removed and the segment must not be revived
+	static bool
+	attach(segment_t* segment)
+	{
+		boost::uint32_t users = segment->users.load();
+		while (users > 0)
+			if (segment->users.compare_exchange_weak(users, users + 1))
+				return true;
+		return false;
+	}
+
+	// what a segment holds: the file by path and identity, the frames
+	// and the format, empty if the file cannot be found
+	static std::string
+	segment_key(const std::string& path, long preloaded, sample_format_t format)
+	{
+		struct stat st;
+		if (::stat(path.c_str(), &st))
+			return std::string();
+		std::ostringstream key;
+		key << SampleStore::Resolve(path) << '\n'
+		    << st.st_dev << ':' << st.st_ino << ':' << st.st_size << ':' << st.st_mtime << '\n'
+		    << preloaded << ':' << int(format);
+		return key.str();
+	}
+
+	// POSIX name of the segment with key, a 64 bit FNV-1a hash
+	static std::string
+	segment_name(const std::string& key)
+	{
+		boost::uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < key.size(); ++i)
+			hash = (hash ^ (unsigned char) key[i]) * 1099511628211ULL;
+		char name[32];
+		std::sprintf(name, "/libsfz-%016llx", (unsigned long long) hash);
+		return name;
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class SharedPool
+
+	Sample*
+	SharedPool::Map(const std::string& path, WavFile& wav, long preloaded, sample_format_t format, double* bytes)
+	{
+		long held = (preloaded >= 0 && preloaded < wav.Frames()) ? preloaded : wav.Frames();
+		std::string key = segment_key(path, held, format);
+		size_t page = ipc::mapped_region::get_page_size();
+		if (key.empty() || sizeof(segment_t) + key.size() > page)
+			return 0;
+
+		boost::shared_ptr<mapping_t> mapping(new mapping_t());
+		mapping->name = segment_name(key);
+		size_t size = Sample::Layout(wav.Channels(), wav.Frames(), held, format);
+		Sample* sample = new Sample();
+
+		// a segment left by a crashed creator is failed and its name
+		// removed, the next round then makes a fresh one; a segment
+		// whose last user is leaving is waited out the same way
+		for (int round = 0; round < 3; ++round)
+		{
+			bool created = false;
+			try
+			{
+				// the first process creates the segment and decodes into it
+				ipc::shared_memory_object shm(ipc::create_only, mapping->name.c_str(), ipc::read_write);
+				created = true;
+				shm.truncate(page + size);
+				ipc::mapped_region header(shm, ipc::read_write, 0, page);
+				ipc::mapped_region frames(shm, ipc::read_write, page, size);
+				mapping->header.swap(header);
+				mapping->frames.swap(frames);
+
+				segment_t* segment = new (mapping->header.get_address()) segment_t();
+				segment->creator = ::getpid();
+				std::memcpy(segment->magic, MAGIC, sizeof(MAGIC));
+				segment->users.store(1);
+				mapping->counted = true;
+				segment->channels = wav.Channels();
+				segment->format = format;
+				segment->frames = wav.Frames();
+				segment->preloaded = held;
+				segment->loop_start = wav.LoopStart();
+				segment->loop_end = wav.LoopEnd();
+				segment->rate = wav.Rate();
+				segment->key_length = key.size();
+				std::memcpy(segment_key(segment), key.data(), key.size());
+
+				sample->Place(wav.Channels(), wav.Frames(), wav.Rate(), held, format,
+					      (unsigned char*) mapping->frames.get_address(), mapping);
+				long read = wav.Read(sample);
+				if (bytes)
+					*bytes += double(read) * wav.FrameSize();
+				if (read < held)
+				{
+					segment->ready.store(2);
+					delete sample;
+					return 0;
+				}
+				segment->ready.store(1, boost::memory_order_release);
+				return sample;
+			}
+			catch (ipc::interprocess_exception&)
+			{
+				// a half made segment must not keep the others waiting
+				if (created)
+				{
+					ipc::shared_memory_object::remove(mapping->name.c_str());
+					delete sample;
+					return 0;
+				}
+			}
+
+			try
+			{
+				// another process made it, wait until it is decoded
+				ipc::shared_memory_object shm(ipc::open_only, mapping->name.c_str(), ipc::read_write);
+				segment_t* segment = 0;
+				bool stale = false;
+				for (int wait = 0; wait < 10000 && !stale; ++wait)
+				{
+					ipc::offset_t length = 0;
+					if (!segment && shm.get_size(length) && length >= ipc::offset_t(page + size))
+					{
+						ipc::mapped_region header(shm, ipc::read_write, 0, page);
+						mapping->header.swap(header);
+						segment = (segment_t*) mapping->header.get_address();
+					}
+					if (segment && segment->ready.load(boost::memory_order_acquire))
+						break;
+					stale = segment && creator_died(segment);
+					if (!stale)
+						boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+				}
+
+				// the creator died, or never even sized the segment: fail
+				// it so that no one waits on it again, only the process
+				// that does so removes the name
+				if (stale || !segment)
+				{
+					boost::uint32_t decoding = 0;
+					if (!segment || segment->ready.compare_exchange_strong(decoding, 2))
+						ipc::shared_memory_object::remove(mapping->name.c_str());
+					ipc::mapped_region none;
+					mapping->header.swap(none);
+					continue;
+				}
+
+				if (segment->ready.load(boost::memory_order_acquire) != 1 ||
+				    std::memcmp(segment->magic, MAGIC, sizeof(MAGIC)) ||
+				    segment->key_length != key.size() || std::memcmp(segment_key(segment), key.data(), key.size()))
+					break;
+
+				if (!attach(segment))
+				{
+					ipc::mapped_region none;
+					mapping->header.swap(none);
+					boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+					continue;
+				}
+				mapping->counted = true;
+				ipc::mapped_region frames(shm, ipc::read_only, page, size);
+				mapping->frames.swap(frames);
+
+				sample->Place(segment->channels, segment->frames, segment->rate, segment->preloaded,
+					      sample_format_t(segment->format), (unsigned char*) mapping->frames.get_address(), mapping);
+				sample->loop_start = segment->loop_start;
+				sample->loop_end = segment->loop_end;
+				return sample;
+			}
+			catch (ipc::interprocess_exception&)
+			{
+				// removed in between, make it anew
+			}
+		}
+
+		delete sample;
+		return 0;
+	}
+
+} // !namespace sfz
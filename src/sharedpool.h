@@ -0,0 +1,69 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SHAREDPOOL_H
+#define LIBSFZ_SHAREDPOOL_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <string>
+
+#include "sample.h"
+#include "wav.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class SharedPool
+
+	/// Decoded audio shared by every process of the host through named
+	/// POSIX shared memory
+	///
+	/// A segment is named after the resolved path and identity (device,
+	/// inode, size and modification time) of the file together with the
+	/// format and the frames held, so a changed file gets a new one.
+	/// The first process decodes into it, the others map the frames
+	/// read-only and only count themselves as users in the writable
+	/// header page; the last user removes the name, and a segment whose
+	/// count reached zero is never attached again. The header records
+	/// the pid of the decoding process: should it die before the frames
+	/// are ready, the first waiter to notice fails the segment, removes
+	/// its name and a fresh one is made.
+	class SharedPool
+	{
+	public:
+		/// Audio of the first preloaded frames (all if negative) of
+		/// path in format, the open wav is decoded into a new segment
+		/// if no process did so yet
+		///
+		/// Returns NULL when the audio cannot be shared, a NULL
+		/// returned for a readable file is no error: the caller keeps
+		/// it in private memory. The bytes read from disk are added to
+		/// bytes if given.
+		static Sample* Map(const std::string& path, WavFile& wav, long preloaded,
+				   sample_format_t format, double* bytes = 0);
+
+	private:
+		SharedPool();
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_SHAREDPOOL_H
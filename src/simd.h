@@ -0,0 +1,263 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SIMD_H
+#define LIBSFZ_SIMD_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Thin wrappers around the vector instruction sets used by the DSP
+// kernels. Kernels are written once as templates over one of the
+// traits below; the AVX2 traits only exist in translation units
+// compiled with AVX2 enabled and are selected at runtime.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LIBSFZ_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LIBSFZ_NEON 1
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <cstring>
+
+namespace sfz
+{
+namespace simd
+{
+
+	// The traits live in an unnamed namespace so that every translation
+	// unit gets its own copy, compiled for its own instruction set; the
+	// linker can then never pick an AVX2 build of a shared inline.
+	namespace
+	{
+
+	/// Return true if the CPU supports AVX2 and FMA
+	inline bool
+	HasAVX2()
+	{
+#if defined(LIBSFZ_HAVE_AVX2) && defined(__GNUC__)
+		static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		return has_avx2;
+#else
+		return false;
+#endif
+	}
+
+	/////////////////////////////////////////////////////////////
+	// struct scalar_t
+
+	struct scalar_t
+	{
+		typedef float V;
+		typedef int I;
+		enum { width = 1 };
+
+		static V load(const float* p) { return *p; }
+		static V loadu(const float* p) { return *p; }
+		static void store(float* p, V a) { *p = a; }
+		static void storeu(float* p, V a) { *p = a; }
+		static V set1(float a) { return a; }
+		static V ramp() { return 0.0f; }
+		static V add(V a, V b) { return a + b; }
+		static V sub(V a, V b) { return a - b; }
+		static V mul(V a, V b) { return a * b; }
+		static V madd(V a, V b, V c) { return a * b + c; }
+		static V min(V a, V b) { return (a < b) ? a : b; }
+		static V max(V a, V b) { return (a > b) ? a : b; }
+		static I trunc(V a) { return (int) a; }
+		static V to_float(I a) { return (float) a; }
+		static V gather(const float* p, I idx) { return p[idx]; }
+		static float hsum(V a) { return a; }
+
+		// 32 bit integer lanes
+		static I loadi(const void* p) { int a; std::memcpy(&a, p, 4); return a; }
+		static I set1i(int a) { return a; }
+		static I andi(I a, I b) { return a & b; }
+		static I xori(I a, I b) { return a ^ b; }
+		static V as_float(I a) { V b; std::memcpy(&b, &a, 4); return b; }
+		static I gatheri(const unsigned char* p, int /* stride */) { return loadi(p); }
+	};
+
+#if defined(LIBSFZ_SSE)
+	/////////////////////////////////////////////////////////////
+	// struct sse_t
+
+	struct sse_t
+	{
+		typedef __m128 V;
+		typedef __m128i I;
+		enum { width = 4 };
+
+		static V load(const float* p) { return _mm_load_ps(p); }
+		static V loadu(const float* p) { return _mm_loadu_ps(p); }
+		static void store(float* p, V a) { _mm_store_ps(p, a); }
+		static void storeu(float* p, V a) { _mm_storeu_ps(p, a); }
+		static V set1(float a) { return _mm_set1_ps(a); }
+		static V ramp() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+		static V add(V a, V b) { return _mm_add_ps(a, b); }
+		static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+		static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+		static V madd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+		static V min(V a, V b) { return _mm_min_ps(a, b); }
+		static V max(V a, V b) { return _mm_max_ps(a, b); }
+		static I trunc(V a) { return _mm_cvttps_epi32(a); }
+		static V to_float(I a) { return _mm_cvtepi32_ps(a); }
+		static V gather(const float* p, I idx)
+		{
+			int i[4];
+			_mm_storeu_si128((__m128i*) i, idx);
+			return _mm_setr_ps(p[i[0]], p[i[1]], p[i[2]], p[i[3]]);
+		}
+		static float hsum(V a)
+		{
+			__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			return _mm_cvtss_f32(s);
+		}
+
+		// 32 bit integer lanes
+		static I loadi(const void* p) { return _mm_loadu_si128((const __m128i*) p); }
+		static I set1i(int a) { return _mm_set1_epi32(a); }
+		static I andi(I a, I b) { return _mm_and_si128(a, b); }
+		static I xori(I a, I b) { return _mm_xor_si128(a, b); }
+		static V as_float(I a) { return _mm_castsi128_ps(a); }
+		static I gatheri(const unsigned char* p, int stride)
+		{
+			int i[4];
+			for (int k = 0; k < 4; ++k)
+				std::memcpy(&i[k], p + k * stride, 4);
+			return _mm_loadu_si128((const __m128i*) i);
+		}
+	};
+
+	typedef sse_t native_t;
+#elif defined(LIBSFZ_NEON)
+	/////////////////////////////////////////////////////////////
+	// struct neon_t
+
+	struct neon_t
+	{
+		typedef float32x4_t V;
+		typedef int32x4_t I;
+		enum { width = 4 };
+
+		static V load(const float* p) { return vld1q_f32(p); }
+		static V loadu(const float* p) { return vld1q_f32(p); }
+		static void store(float* p, V a) { vst1q_f32(p, a); }
+		static void storeu(float* p, V a) { vst1q_f32(p, a); }
+		static V set1(float a) { return vdupq_n_f32(a); }
+		static V ramp() { static const float r[4] = { 0.0f, 1.0f, 2.0f, 3.0f }; return vld1q_f32(r); }
+		static V add(V a, V b) { return vaddq_f32(a, b); }
+		static V sub(V a, V b) { return vsubq_f32(a, b); }
+		static V mul(V a, V b) { return vmulq_f32(a, b); }
+		static V madd(V a, V b, V c) { return vmlaq_f32(c, a, b); }
+		static V min(V a, V b) { return vminq_f32(a, b); }
+		static V max(V a, V b) { return vmaxq_f32(a, b); }
+		static I trunc(V a) { return vcvtq_s32_f32(a); }
+		static V to_float(I a) { return vcvtq_f32_s32(a); }
+		static V gather(const float* p, I idx)
+		{
+			float r[4] = { p[vgetq_lane_s32(idx, 0)], p[vgetq_lane_s32(idx, 1)],
+				       p[vgetq_lane_s32(idx, 2)], p[vgetq_lane_s32(idx, 3)] };
+			return vld1q_f32(r);
+		}
+		static float hsum(V a)
+		{
+			float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+			return vget_lane_f32(vpadd_f32(s, s), 0);
+		}
+
+		// 32 bit integer lanes
+		static I loadi(const void* p) { return vreinterpretq_s32_u8(vld1q_u8((const uint8_t*) p)); }
+		static I set1i(int a) { return vdupq_n_s32(a); }
+		static I andi(I a, I b) { return vandq_s32(a, b); }
+		static I xori(I a, I b) { return veorq_s32(a, b); }
+		static V as_float(I a) { return vreinterpretq_f32_s32(a); }
+		static I gatheri(const unsigned char* p, int stride)
+		{
+			int i[4];
+			for (int k = 0; k < 4; ++k)
+				std::memcpy(&i[k], p + k * stride, 4);
+			return vld1q_s32(i);
+		}
+	};
+
+	typedef neon_t native_t;
+#else
+	typedef scalar_t native_t;
+#endif
+
+#if defined(__AVX2__)
+	/////////////////////////////////////////////////////////////
+	// struct avx2_t
+
+	struct avx2_t
+	{
+		typedef __m256 V;
+		typedef __m256i I;
+		enum { width = 8 };
+
+		static V load(const float* p) { return _mm256_load_ps(p); }
+		static V loadu(const float* p) { return _mm256_loadu_ps(p); }
+		static void store(float* p, V a) { _mm256_store_ps(p, a); }
+		static void storeu(float* p, V a) { _mm256_storeu_ps(p, a); }
+		static V set1(float a) { return _mm256_set1_ps(a); }
+		static V ramp() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+		static V add(V a, V b) { return _mm256_add_ps(a, b); }
+		static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+		static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+		static V madd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+		static V min(V a, V b) { return _mm256_min_ps(a, b); }
+		static V max(V a, V b) { return _mm256_max_ps(a, b); }
+		static I trunc(V a) { return _mm256_cvttps_epi32(a); }
+		static V to_float(I a) { return _mm256_cvtepi32_ps(a); }
+		static V gather(const float* p, I idx) { return _mm256_i32gather_ps(p, idx, 4); }
+		static float hsum(V a)
+		{
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			return _mm_cvtss_f32(s);
+		}
+
+		// 32 bit integer lanes
+		static I loadi(const void* p) { return _mm256_loadu_si256((const __m256i*) p); }
+		static I set1i(int a) { return _mm256_set1_epi32(a); }
+		static I andi(I a, I b) { return _mm256_and_si256(a, b); }
+		static I xori(I a, I b) { return _mm256_xor_si256(a, b); }
+		static V as_float(I a) { return _mm256_castsi256_ps(a); }
+		static I gatheri(const unsigned char* p, int stride)
+		{
+			const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+								   _mm256_set1_epi32(stride));
+			return _mm256_i32gather_epi32((const int*) p, offsets, 1);
+		}
+	};
+#endif
+
+	} // !namespace
+
+} // !namespace simd
+} // !namespace sfz
+
+#endif // !LIBSFZ_SIMD_H
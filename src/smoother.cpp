@@ -0,0 +1,174 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "smoother.h"
+
+#include <cmath>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Smoother
+
+	Smoother::Smoother(int capacity, int subdivisions) :
+		_mode(SMOOTH_ONE_POLE),
+		_capacity(0),
+		_subdivisions(subdivisions < 1 ? 1 : subdivisions),
+		_sub_block_size(16),
+		_block_size(64),
+		_levels(6),
+		_sample_rate(44100)
+	{
+		Resize(capacity);
+	}
+
+	Smoother::~Smoother()
+	{
+	}
+
+	void
+	Smoother::Resize(int capacity)
+	{
+		_capacity = capacity;
+		_value.assign(capacity, 0.0f);
+		_target.assign(capacity, 0.0f);
+		_coeff.assign(capacity, 1.0f);
+		_retain.assign(capacity * _levels, 0.0f);
+		_partial.assign(capacity, 1.0f);
+		_snap.assign(capacity, 0.0f);
+		_steps.assign(capacity, 1.0f);
+		_delta.assign(capacity, 0.0f);
+		_remaining.assign(capacity, 0.0f);
+		_ramp.assign(capacity * _subdivisions, 0.0f);
+	}
+
+	void
+	Smoother::SetRate(float sample_rate, int block_size)
+	{
+		_sample_rate = sample_rate;
+		_sub_block_size = block_size / _subdivisions;
+		if (_sub_block_size < 1)
+			_sub_block_size = 1;
+
+		// a short block of n frames is made of the levels of n's bits
+		_block_size = _sub_block_size * _subdivisions;
+		_levels = 1;
+		while ((1 << _levels) < _block_size)
+			++_levels;
+		_retain.assign(_capacity * _levels, 0.0f);
+	}
+
+	void
+	Smoother::Reset(int slot, float value, float smooth_ms)
+	{
+		// smoothing time expressed in sub-blocks
+		float steps = smooth_ms * 0.001f * _sample_rate / _sub_block_size;
+
+		_value[slot] = value;
+		_target[slot] = value;
+		_delta[slot] = 0;
+		_remaining[slot] = 0;
+		_snap[slot] = 0;
+		if (steps <= 1.0f)
+		{
+			_coeff[slot] = 1.0f;
+			_steps[slot] = 1.0f;
+			for (int l = 0; l < _levels; ++l)
+				_retain[l * _capacity + slot] = 0.0f;
+		}
+		else
+		{
+			// reach ~95% of a step within the smoothing time
+			_coeff[slot] = 1.0f - std::exp(-3.0f / steps);
+			_steps[slot] = std::floor(steps + 0.5f);
+			for (int l = 0; l < _levels; ++l)
+				_retain[l * _capacity + slot] = std::exp(-3.0f / steps * (1 << l) / _block_size);
+		}
+		for (int k = 0; k < _subdivisions; ++k)
+			_ramp[k * _capacity + slot] = value;
+	}
+
+	void
+	Smoother::Process(int count, float fraction)
+	{
+		if (count <= 0)
+			return;
+
+		float* value = &_value[0];
+		const float* target = &_target[0];
+
+		if (_mode == SMOOTH_ONE_POLE)
+		{
+			// n frames of a short block keep (1 - coeff)^(n / block size)
+			// of the distance, the product of the retains of n's bits
+			const float* coeff = &_coeff[0];
+			int frames = int(fraction * _block_size + 0.5f);
+			if (frames < _block_size)
+			{
+				for (int i = 0; i < count; ++i)
+					_partial[i] = 1.0f;
+				for (int l = 0; l < _levels; ++l)
+				{
+					if (!(frames & (1 << l)))
+						continue;
+					const float* retain = &_retain[l * _capacity];
+					for (int i = 0; i < count; ++i)
+						_partial[i] *= retain[i];
+				}
+				for (int i = 0; i < count; ++i)
+					_partial[i] = 1.0f - _partial[i];
+				coeff = &_partial[0];
+			}
+			const float* snap = &_snap[0];
+			for (int k = 0; k < _subdivisions; ++k)
+			{
+				float* ramp = &_ramp[k * _capacity];
+				for (int i = 0; i < count; ++i)
+				{
+					float v = value[i] + coeff[i] * (target[i] - value[i]);
+					// snap once the remaining distance is negligible
+					v = (std::fabs(target[i] - v) <= snap[i]) ? target[i] : v;
+					value[i] = v;
+					ramp[i] = v;
+				}
+			}
+		}
+		else
+		{
+			const float* delta = &_delta[0];
+			float* remaining = &_remaining[0];
+			for (int k = 0; k < _subdivisions; ++k)
+			{
+				float* ramp = &_ramp[k * _capacity];
+				for (int i = 0; i < count; ++i)
+				{
+					float r = remaining[i] - fraction;
+					float v = (r > 0.0f) ? value[i] + delta[i] * fraction : target[i];
+					remaining[i] = (r > 0.0f) ? r : 0.0f;
+					value[i] = v;
+					ramp[i] = v;
+				}
+			}
+		}
+	}
+
+} // !namespace sfz
@@ -0,0 +1,119 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_SMOOTHER_H
+#define LIBSFZ_SMOOTHER_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <cmath>
+#include <vector>
+
+namespace sfz
+{
+
+	// Enumerations
+	enum smooth_mode_t { SMOOTH_ONE_POLE, SMOOTH_LINEAR };
+
+	/////////////////////////////////////////////////////////////
+	// class Smoother
+
+	/// Block based smoothing of a control parameter for many voices
+	///
+	/// Each slot (normally one per voice) glides from its current
+	/// value towards its target over the smoothing time given in ms
+	/// by the *_smoothccN opcodes. A block is split into a fixed
+	/// number of sub-blocks and the value at the end of each one is
+	/// written to the ramp, so a filter only has to recompute its
+	/// coefficients once per sub-block. State is kept as one array per
+	/// field, making Process() a set of plain loops over the slots
+	/// that the compiler vectorizes.
+	class Smoother
+	{
+	public:
+		Smoother(int capacity = 0, int subdivisions = 4);
+		virtual ~Smoother();
+
+		/// Allocate storage for capacity slots, not real-time safe
+		void Resize(int capacity);
+
+		/// Select one-pole (exponential) or linear ramps
+		void SetMode(smooth_mode_t mode) { _mode = mode; }
+
+		/// Set the sample rate and the number of frames per block
+		void SetRate(float sample_rate, int block_size);
+
+		/// Start slot at value with the given smoothing time
+		void Reset(int slot, float value, float smooth_ms);
+
+		/// Set a new value for slot to glide to, a one-pole glide snaps
+		/// to it once within 0.1% of the jump, whatever the units
+		void SetTarget(int slot, float target)
+		{
+			if (target == _target[slot])
+				return;
+			_snap[slot] = 1e-3f * std::fabs(target - _value[slot]);
+			_target[slot] = target;
+			_delta[slot] = (target - _value[slot]) / _steps[slot];
+			_remaining[slot] = _steps[slot];
+		}
+
+		/// Advance the slots [0, count) by one block, or the fraction of
+		/// one for a short block (a whole number of frames of it); the
+		/// sub-blocks then divide the short block evenly
+		void Process(int count, float fraction = 1.0f);
+
+		/// Value of slot at the end of sub-block k of the last block
+		float Get(int k, int slot) const { return _ramp[k * _capacity + slot]; }
+
+		/// Pointer to the values of sub-block k of all slots
+		const float* GetRamp(int k) const { return &_ramp[k * _capacity]; }
+
+		/// Current value of slot
+		float GetValue(int slot) const { return _value[slot]; }
+
+		/// Return true if slot has reached its target
+		bool IsSettled(int slot) const { return _value[slot] == _target[slot]; }
+
+		int Subdivisions() const { return _subdivisions; }
+		int SubBlockSize() const { return _sub_block_size; }
+
+	private:
+		smooth_mode_t _mode;
+		int _capacity;
+		int _subdivisions;
+		int _sub_block_size;
+		int _block_size;
+		int _levels;
+		float _sample_rate;
+
+		std::vector<float> _value;
+		std::vector<float> _target;
+		std::vector<float> _coeff;      // one-pole coefficient per sub-block
+		std::vector<float> _retain;     // [level][slot], (1 - coeff)^(2^level / block size)
+		std::vector<float> _partial;    // coefficient for the fraction of a short block
+		std::vector<float> _snap;       // distance to the target that ends a glide
+		std::vector<float> _steps;      // linear ramp length in sub-blocks
+		std::vector<float> _delta;      // linear increment per sub-block
+		std::vector<float> _remaining;  // linear sub-blocks left
+		std::vector<float> _ramp;       // [sub-block][slot]
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_SMOOTHER_H
@@ -0,0 +1,152 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "stereo.h"
+#include "stereo_kernels.h"
+
+#include <cmath>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// gain table
+
+	static float quarter[StereoMixer::TABLE_SIZE + 1];
+
+	static struct quarter_init_t
+	{
+		quarter_init_t()
+		{
+			for (int i = 0; i <= StereoMixer::TABLE_SIZE; ++i)
+				quarter[i] = std::cos(1.57079632679490 * i / StereoMixer::TABLE_SIZE);
+		}
+	} quarter_init;
+
+	// cos and sin of x * pi/2 for x in 0-1
+	static void
+	exact(float x, float& c, float& s)
+	{
+		c = std::cos(1.57079632679490f * x);
+		s = std::sin(1.57079632679490f * x);
+	}
+
+	static void
+	lookup(float x, float& c, float& s)
+	{
+		float p = x * StereoMixer::TABLE_SIZE;
+		int i = int(p);
+		if (i >= StereoMixer::TABLE_SIZE)
+			i = StereoMixer::TABLE_SIZE - 1;
+		float f = p - i;
+		int j = StereoMixer::TABLE_SIZE - i;
+		c = quarter[i] + f * (quarter[i + 1] - quarter[i]);
+		s = quarter[j] + f * (quarter[j - 1] - quarter[j]);
+	}
+
+	// percent -100..100 to 0-1
+	static float
+	unit(float percent)
+	{
+		if (percent < -100)
+			percent = -100;
+		else if (percent > 100)
+			percent = 100;
+		return (percent + 100) / 200;
+	}
+
+	static stereo_t
+	place(int channels, float pan, float width, float position, void (*gains)(float, float&, float&))
+	{
+		// equal-power pairs, pan and position scaled to unity at center
+		const float center = 1.41421356237310f;
+		float pan_l, pan_r;
+		gains(unit(pan), pan_l, pan_r);
+		pan_l *= center;
+		pan_r *= center;
+
+		stereo_t m;
+		if (channels != 2)
+		{
+			m.ll = pan_l;
+			m.lr = pan_r;
+			m.rl = m.rr = 0;
+			return m;
+		}
+
+		// width 100 keeps the sides, 0 sums them and -100 swaps them
+		float cross, keep;
+		gains(unit(width), cross, keep);
+
+		float pos_l, pos_r;
+		gains(unit(position), pos_l, pos_r);
+		float left = pan_l * pos_l * center;
+		float right = pan_r * pos_r * center;
+
+		m.ll = left * keep;
+		m.rl = left * cross;
+		m.lr = right * cross;
+		m.rr = right * keep;
+		return m;
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class StereoMixer
+
+	StereoMixer::StereoMixer()
+	{
+#if defined(LIBSFZ_HAVE_AVX2)
+		if (simd::HasAVX2())
+		{
+			_mix[0] = kernels::avx2_mix(1);
+			_mix[1] = kernels::avx2_mix(2);
+		}
+		else
+#endif
+		{
+			_mix[0] = &kernels::mix_mono<simd::native_t>;
+			_mix[1] = &kernels::mix_stereo<simd::native_t>;
+		}
+	}
+
+	StereoMixer::~StereoMixer()
+	{
+	}
+
+	stereo_t
+	StereoMixer::Place(int channels, float pan, float width, float position)
+	{
+		return place(channels, pan, width, position, &exact);
+	}
+
+	stereo_t
+	StereoMixer::Lookup(int channels, float pan, float width, float position)
+	{
+		return place(channels, pan, width, position, &lookup);
+	}
+
+	const float*
+	StereoMixer::Table()
+	{
+		return quarter;
+	}
+
+} // !namespace sfz
@@ -0,0 +1,87 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_STEREO_H
+#define LIBSFZ_STEREO_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+namespace sfz
+{
+
+	/// Gains from the channels of a voice to the outputs
+	///
+	/// left += ll * l + rl * r
+	/// right += lr * l + rr * r
+	///
+	/// a mono voice only uses ll and lr.
+	struct stereo_t
+	{
+		float ll, rl;
+		float lr, rr;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class StereoMixer
+
+	/// Stereo placement and mix-down of voices
+	///
+	/// pan, width and position resolve into one stereo_t. A mono
+	/// voice is panned between the outputs. A stereo voice is first
+	/// narrowed or swapped by width, then pan sets the balance of its
+	/// two sides and position moves the whole image. Every gain is
+	/// equal-power and centered settings are unity, so an unplaced
+	/// voice plays as before.
+	///
+	/// Place() is exact and meant for compile time; Lookup() reads a
+	/// shared TABLE_SIZE step table instead of calling sin and cos, for
+	/// placement modulated by controllers. Mix() applies the matrix in
+	/// a SIMD kernel, AVX2 selected at runtime where available.
+	class StereoMixer
+	{
+	public:
+		enum { TABLE_SIZE = 1024 };
+
+		StereoMixer();
+		virtual ~StereoMixer();
+
+		/// Placement of a voice of channels (1 or 2), all in percent
+		static stereo_t Place(int channels, float pan, float width, float position);
+		static stereo_t Lookup(int channels, float pan, float width, float position);
+
+		/// Add frames of the channels of in, times env and a gain going
+		/// linearly from gain by step per frame, into left and right
+		void Mix(const stereo_t& matrix, const float* const* in, int channels, const float* env,
+			 float gain, float step, float* left, float* right, int frames) const
+		{
+			_mix[(channels == 2) ? 1 : 0](matrix, in, env, gain, step, left, right, frames);
+		}
+
+		typedef void (*mix_fn)(const stereo_t& matrix, const float* const* in, const float* env,
+				       float gain, float step, float* left, float* right, int frames);
+
+		/// Quarter cosine from 0 to pi/2, TABLE_SIZE + 1 values
+		static const float* Table();
+
+	private:
+		mix_fn _mix[2];
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_STEREO_H
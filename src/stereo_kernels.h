@@ -0,0 +1,111 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_STEREO_KERNELS_H
+#define LIBSFZ_STEREO_KERNELS_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Mix-down kernels shared by the per instruction set translation
+// units. Not part of the public interface.
+
+#include "stereo.h"
+#include "simd.h"
+
+namespace sfz
+{
+namespace kernels
+{
+
+#if defined(LIBSFZ_HAVE_AVX2)
+	/// Mix kernel for channels compiled for AVX2, defined in stereo_avx2.cpp
+	StereoMixer::mix_fn avx2_mix(int channels);
+#endif
+
+	// one copy per translation unit, see simd.h
+	namespace
+	{
+
+	// the buffers have no alignment, the tail is done one frame at a time
+	template<class S>
+	void
+	mix_mono(const stereo_t& matrix, const float* const* in, const float* env,
+		 float gain, float step, float* left, float* right, int frames)
+	{
+		typedef typename S::V V;
+		const V ll = S::set1(matrix.ll);
+		const V lr = S::set1(matrix.lr);
+		const V advance = S::set1(step * S::width);
+		V g = S::madd(S::ramp(), S::set1(step), S::set1(gain));
+
+		const float* mono = in[0];
+		int i = 0;
+		for (; i + S::width <= frames; i += S::width)
+		{
+			V a = S::mul(S::mul(g, S::loadu(env + i)), S::loadu(mono + i));
+			S::storeu(left + i, S::madd(a, ll, S::loadu(left + i)));
+			S::storeu(right + i, S::madd(a, lr, S::loadu(right + i)));
+			g = S::add(g, advance);
+		}
+		for (; i < frames; ++i)
+		{
+			float a = (gain + step * i) * env[i] * mono[i];
+			left[i] += a * matrix.ll;
+			right[i] += a * matrix.lr;
+		}
+	}
+
+	template<class S>
+	void
+	mix_stereo(const stereo_t& matrix, const float* const* in, const float* env,
+		   float gain, float step, float* left, float* right, int frames)
+	{
+		typedef typename S::V V;
+		const V ll = S::set1(matrix.ll);
+		const V rl = S::set1(matrix.rl);
+		const V lr = S::set1(matrix.lr);
+		const V rr = S::set1(matrix.rr);
+		const V advance = S::set1(step * S::width);
+		V g = S::madd(S::ramp(), S::set1(step), S::set1(gain));
+
+		int i = 0;
+		for (; i + S::width <= frames; i += S::width)
+		{
+			V a = S::mul(g, S::loadu(env + i));
+			V l = S::mul(a, S::loadu(in[0] + i));
+			V r = S::mul(a, S::loadu(in[1] + i));
+			S::storeu(left + i, S::madd(l, ll, S::madd(r, rl, S::loadu(left + i))));
+			S::storeu(right + i, S::madd(l, lr, S::madd(r, rr, S::loadu(right + i))));
+			g = S::add(g, advance);
+		}
+		for (; i < frames; ++i)
+		{
+			float a = (gain + step * i) * env[i];
+			float l = a * in[0][i];
+			float r = a * in[1][i];
+			left[i] += l * matrix.ll + r * matrix.rl;
+			right[i] += l * matrix.lr + r * matrix.rr;
+		}
+	}
+
+	} // !namespace
+
+} // !namespace kernels
+} // !namespace sfz
+
+#endif // !LIBSFZ_STEREO_KERNELS_H
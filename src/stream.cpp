@@ -0,0 +1,303 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/bind/bind.hpp>
+
+#include "stream.h"
+#include "samplestore.h"
+#include "playback.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Stream
+
+	Stream::Stream() :
+		_capacity(0),
+		_sample(-1),
+		_start(0),
+		_request(0),
+		_read(0),
+		_ack(0),
+		_written(0),
+		_underruns(0),
+		_wake(0),
+		_hungry(false),
+		_refill(0),
+		_serving(0),
+		_source(-1),
+		_offset(0),
+		_filled(0),
+		_open(-1)
+	{
+	}
+
+	Stream::~Stream()
+	{
+	}
+
+	void
+	Stream::Resize(long frames)
+	{
+		_capacity = 1;
+		while (_capacity < frames)
+			_capacity <<= 1;
+		for (int c = 0; c < 2; ++c)
+			_data[c].assign(_capacity, 0.0f);
+	}
+
+	void
+	Stream::start(int sample, long start)
+	{
+		// the fields are published by the release of the new request
+		_read.store(0, boost::memory_order_relaxed);
+		_sample.store(sample, boost::memory_order_relaxed);
+		_start.store(start, boost::memory_order_relaxed);
+		_request.fetch_add(1, boost::memory_order_release);
+		_hungry.store(false, boost::memory_order_relaxed);
+		if (_wake)
+			_wake->post();
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class DiskStreamer
+
+	DiskStreamer::DiskStreamer(int streams, int threads, long ring) :
+		_streams(streams),
+		_threads((threads > 0) ? threads : 1),
+		_stream(new Stream[streams]),
+		_wake(new wake_t[_threads]),
+		_quit(false)
+	{
+		for (int s = 0; s < _streams; ++s)
+		{
+			_stream[s].Resize(ring);
+			_stream[s]._wake = &_wake[s % _threads].semaphore;
+			_stream[s]._refill = std::min<long>(CHUNK, _stream[s].Capacity() / 2);
+		}
+		for (int t = 0; t < _threads; ++t)
+			_workers.create_thread(boost::bind(&DiskStreamer::run, this, t));
+	}
+
+	DiskStreamer::~DiskStreamer()
+	{
+		_quit.store(true, boost::memory_order_release);
+		for (int t = 0; t < _threads; ++t)
+			_wake[t].semaphore.post();
+		_workers.join_all();
+		for (std::map<int, const Sample*>::iterator it = _heads.begin(); it != _heads.end(); ++it)
+			SampleStore::Instance().Release(it->first, it->second);
+	}
+
+	void
+	DiskStreamer::Preload(const Instrument* instrument, long preload, SampleLoader* loader)
+	{
+		// frames each sample needs in memory: the furthest a voice can
+		// start into it plus preload frames to cover the disk latency,
+		// and loops are kept whole so the stream only ever runs forward
+		std::map<int, long> heads;
+		for (size_t i = 0; i < instrument->regions.size(); ++i)
+		{
+			const Region* region = instrument->regions[i];
+			if (region->sample < 0)
+				continue;
+			long offset = region->offset ? *region->offset : 0;
+			if (region->offset_random)
+				offset += *region->offset_random;
+			// the modulation matrix sums the offset_onccN of every
+			// controller, so all of them can push the start at once
+			for (int cc = 0; cc < 128; ++cc)
+				if (region->offset_oncc[cc] && *region->offset_oncc[cc] > 0)
+					offset += *region->offset_oncc[cc];
+
+			long head = offset + preload;
+			if ((region->loop_mode == LOOP_CONTINOUS || region->loop_mode == LOOP_SUSTAIN) &&
+			    region->loop_end && *region->loop_end + 1 > head)
+				head = *region->loop_end + 1;
+			head += Resampler::MAX_AFTER;
+
+			long& known = heads[region->sample];
+			if (head > known)
+				known = head;
+		}
+
+		// heads are read in parallel and shared with every other
+		// streamer through the store, one reference is held per sample
+		// and streamer; loops found in the files take a second round
+		SampleStore& store = SampleStore::Instance();
+		SampleLoader pool;
+		if (!loader)
+			loader = &pool;
+
+		for (int round = 0; round < 2 && !heads.empty(); ++round)
+		{
+			std::vector<int> ids;
+			loader->Clear();
+			for (std::map<int, long>::iterator it = heads.begin(); it != heads.end(); ++it)
+			{
+				std::map<int, const Sample*>::iterator known = _heads.find(it->first);
+				if (known != _heads.end() &&
+				    (known->second->Preloaded() >= it->second ||
+				     known->second->Preloaded() == known->second->Frames()))
+					continue;
+				loader->Add(it->first, it->second, instrument->storage);
+				ids.push_back(it->first);
+			}
+			loader->Run();
+
+			std::map<int, long> loops;
+			for (size_t i = 0; i < ids.size(); ++i)
+			{
+				const Sample* sample = loader->Get(i);
+				if (!sample)
+				{
+					std::cerr << "The sample '" << store.Path(ids[i]) << "' could not be loaded by libsfz!" << std::endl;
+					continue;
+				}
+				std::map<int, const Sample*>::iterator known = _heads.find(ids[i]);
+				if (known != _heads.end())
+					store.Release(ids[i], known->second);
+				_heads[ids[i]] = sample;
+
+				long loop = sample->loop_end + 1 + Resampler::MAX_AFTER;
+				if (sample->loop_end >= 0 && loop > sample->Preloaded())
+					loops[ids[i]] = loop;
+			}
+			heads.swap(loops);
+		}
+	}
+
+	const Sample*
+	DiskStreamer::GetSample(int sample) const
+	{
+		std::map<int, const Sample*>::const_iterator it = _heads.find(sample);
+		return (it != _heads.end()) ? it->second : 0;
+	}
+
+	Stream*
+	DiskStreamer::Open(int slot, int sample, long start)
+	{
+		Stream* stream = &_stream[slot];
+		stream->start(sample, start);
+		return stream;
+	}
+
+	void
+	DiskStreamer::Close(int slot)
+	{
+		_stream[slot].start(-1, 0);
+	}
+
+	unsigned long
+	DiskStreamer::Underruns() const
+	{
+		unsigned long underruns = 0;
+		for (int s = 0; s < _streams; ++s)
+			underruns += _stream[s]._underruns.load(boost::memory_order_relaxed);
+		return underruns;
+	}
+
+	void
+	DiskStreamer::run(int thread)
+	{
+		while (!_quit.load(boost::memory_order_acquire))
+		{
+			// one chunk per stream and pass, sleep until a request or
+			// a consumer makes room when none has anything to read
+			bool busy = false;
+			for (int s = thread; s < _streams; s += _threads)
+				busy = service(_stream[s]) || busy;
+			if (!busy)
+				_wake[thread].semaphore.wait();
+		}
+	}
+
+	bool
+	DiskStreamer::service(Stream& stream)
+	{
+		unsigned request = stream._request.load(boost::memory_order_acquire);
+		if (request != stream._serving)
+		{
+			stream._serving = request;
+			stream._source = stream._sample.load(boost::memory_order_relaxed);
+			stream._offset = stream._start.load(boost::memory_order_relaxed);
+			stream._filled = 0;
+			stream._written.store(0, boost::memory_order_relaxed);
+			stream._ack.store(request, boost::memory_order_release);
+		}
+		if (stream._source < 0)
+			return false;
+
+		if (stream._open != stream._source)
+		{
+			std::string path = SampleStore::Instance().Path(stream._source);
+			stream._open = stream._wav.Open(path) ? stream._source : -1;
+			if (stream._open < 0)
+			{
+				stream._source = -1;
+				return false;
+			}
+		}
+
+		// never past the oldest frame the voice may still read, nor
+		// across the end of the ring (the rest follows next pass)
+		long space = stream._read.load(boost::memory_order_acquire) + stream._capacity - stream._filled;
+		if (space <= 0)
+		{
+			// ask the reader for a wake up, then look again in case it
+			// consumed before it could see the request
+			stream._hungry.store(true, boost::memory_order_seq_cst);
+			space = stream._read.load(boost::memory_order_seq_cst) + stream._capacity - stream._filled;
+			if (space <= 0)
+				return false;
+			stream._hungry.store(false, boost::memory_order_relaxed);
+		}
+		long left = stream._wav.Frames() - stream._offset - stream._filled;
+		long at = stream._filled & stream.Mask();
+		long n = CHUNK;
+		if (n > space)
+			n = space;
+		if (n > left)
+			n = left;
+		if (n > stream._capacity - at)
+			n = stream._capacity - at;
+		if (n <= 0)
+			return false;
+
+		float* out[2] = { &stream._data[0][at], &stream._data[1][at] };
+		n = stream._wav.Read(stream._offset + stream._filled, n, out);
+		if (n <= 0)
+		{
+			stream._source = -1;
+			return false;
+		}
+
+		stream._filled += n;
+		stream._written.store(stream._filled, boost::memory_order_release);
+		return true;
+	}
+
+} // !namespace sfz
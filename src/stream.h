@@ -0,0 +1,189 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_STREAM_H
+#define LIBSFZ_STREAM_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <map>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/interprocess/sync/interprocess_semaphore.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "sfz.h"
+#include "sample.h"
+#include "wav.h"
+#include "sampleloader.h"
+
+namespace sfz
+{
+
+	// Forward declarations
+	class DiskStreamer;
+
+	/////////////////////////////////////////////////////////////
+	// class Stream
+
+	/// Ring buffer of the frames of a sample file after its head
+	///
+	/// A single producer, single consumer ring: the audio thread reads
+	/// and the I/O thread of the DiskStreamer writes, neither ever
+	/// waits for the other. The I/O thread sleeps while it has nothing
+	/// to do, a new request or room for a refill in a full ring posts
+	/// its semaphore, which never blocks the audio thread. Frames are
+	/// counted from the start of the request, frame i lives at
+	/// i & (Capacity() - 1) in the ring.
+	class Stream
+	{
+	public:
+		Stream();
+		virtual ~Stream();
+
+		/// Allocate a ring of at least frames frames, not real-time safe
+		void Resize(long frames);
+
+		/// Frames written since the last Start(), 0 until the I/O thread has seen it
+		long Available() const
+		{
+			if (_ack.load(boost::memory_order_acquire) != _request.load(boost::memory_order_relaxed))
+				return 0;
+			return _written.load(boost::memory_order_acquire);
+		}
+
+		/// Let the frames before frame be overwritten
+		void Consume(long frame)
+		{
+			if (frame <= _read.load(boost::memory_order_relaxed))
+				return;
+			_read.store(frame, boost::memory_order_seq_cst);
+			if (_hungry.load(boost::memory_order_seq_cst) &&
+			    frame + _capacity - _written.load(boost::memory_order_relaxed) >= _refill &&
+			    _hungry.exchange(false, boost::memory_order_relaxed))
+				_wake->post();
+		}
+
+		/// Count a block that needed frames not read from disk yet
+		void Underrun() { _underruns.fetch_add(1, boost::memory_order_relaxed); }
+
+		const float* Data(int channel) const { return &_data[channel][0]; }
+		long Capacity() const { return _capacity; }
+		long Mask() const { return _capacity - 1; }
+
+	private:
+		friend class DiskStreamer;
+
+		// audio thread side
+		void start(int sample, long start);
+
+		std::vector<float> _data[2];
+		long _capacity;
+
+		// request of the audio thread, published by _request
+		boost::atomic<int> _sample;
+		boost::atomic<long> _start;
+		boost::atomic<unsigned> _request;
+		boost::atomic<long> _read;
+
+		// progress of the I/O thread, _ack is the request it serves
+		boost::atomic<unsigned> _ack;
+		boost::atomic<long> _written;
+		boost::atomic<unsigned long> _underruns;
+
+		// the I/O thread waits on _wake, _hungry once the ring is full
+		// until _refill frames are free again
+		boost::interprocess::interprocess_semaphore* _wake;
+		boost::atomic<bool> _hungry;
+		long _refill;
+
+		// I/O thread state, the request served and the file it reads
+		unsigned _serving;
+		int _source;
+		long _offset;
+		long _filled;
+		int _open;
+		WavFile _wav;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class DiskStreamer
+
+	/// Preloaded sample heads plus background streaming of the rest
+	///
+	/// Preload() keeps the first frames of every sample of an instrument
+	/// in memory, enough to cover the sample offsets and loops of the
+	/// regions playing it. The heads are shared through the SampleStore.
+	/// A voice starts from its head while the I/O threads fill its
+	/// Stream with the frames that follow, so the audio thread never
+	/// touches the disk. Each I/O thread serves every threads-th stream
+	/// in turn, a chunk at a time, and sleeps when none needs frames.
+	class DiskStreamer
+	{
+	public:
+		DiskStreamer(int streams, int threads = 1, long ring = 65536);
+		virtual ~DiskStreamer();
+
+		/// Load the heads of the samples used by instrument, preload
+		/// frames at least, on the workers of loader (a pool of its own
+		/// if NULL), not real-time safe and must not run concurrently
+		/// with Open()
+		void Preload(const Instrument* instrument, long preload = 32768, SampleLoader* loader = 0);
+
+		/// Head of the sample with SampleStore id sample, NULL if it is not preloaded
+		const Sample* GetSample(int sample) const;
+
+		/// Restart stream slot on the frames of sample from start on, real-time safe
+		Stream* Open(int slot, int sample, long start);
+
+		/// Stop filling stream slot, real-time safe
+		void Close(int slot);
+
+		int Streams() const { return _streams; }
+
+		/// Blocks played with missing frames, over all streams
+		unsigned long Underruns() const;
+
+		/// Frames read per I/O request
+		enum { CHUNK = 8192 };
+
+	private:
+		void run(int thread);
+		bool service(Stream& stream);
+
+		// one semaphore per I/O thread, posted for the streams it serves
+		struct wake_t
+		{
+			wake_t() : semaphore(0) {}
+			boost::interprocess::interprocess_semaphore semaphore;
+		};
+
+		int _streams;
+		int _threads;
+		boost::scoped_array<Stream> _stream;
+		boost::scoped_array<wake_t> _wake;
+		std::map<int, const Sample*> _heads;
+		boost::atomic<bool> _quit;
+		boost::thread_group _workers;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_STREAM_H
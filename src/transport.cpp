@@ -0,0 +1,97 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "transport.h"
+
+#include <cmath>
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Transport
+
+	Transport::Transport() :
+		_tempo(120),
+		_position(0),
+		_numerator(4),
+		_denominator(4),
+		_bar(0),
+		_sample_rate(44100)
+	{
+		update();
+	}
+
+	Transport::~Transport()
+	{
+	}
+
+	void
+	Transport::SetTempo(double bpm)
+	{
+		_tempo = (bpm > 0) ? bpm : _tempo;
+		update();
+	}
+
+	void
+	Transport::SetTimeSignature(int numerator, int denominator, double bar)
+	{
+		_numerator = (numerator > 0) ? numerator : 4;
+		_denominator = (denominator > 0) ? denominator : 4;
+		_bar = bar;
+	}
+
+	void
+	Transport::SetSampleRate(float rate)
+	{
+		_sample_rate = rate;
+		update();
+	}
+
+	long
+	Transport::FramesUntil(double position) const
+	{
+		// a little slack keeps positions reached by Advance() from
+		// rounding up to the next frame
+		double frames = (position - _position) * _frames_per_quarter;
+		if (frames <= 1e-6)
+			return 0;
+		return long(std::ceil(frames - 1e-6));
+	}
+
+	double
+	Transport::NextGrid(double position, double beats, double offset) const
+	{
+		double step = beats * BeatLength();
+		double origin = _bar + offset * BeatLength();
+		if (step <= 0)
+			return position;
+		double k = std::ceil((position - origin) / step - 1e-9);
+		return origin + k * step;
+	}
+
+	void
+	Transport::update()
+	{
+		_frames_per_quarter = _sample_rate * 60.0 / _tempo;
+	}
+
+} // !namespace sfz
@@ -0,0 +1,97 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_TRANSPORT_H
+#define LIBSFZ_TRANSPORT_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class Transport
+
+	/// Musical time of the host: tempo, position and time signature
+	///
+	/// Positions are counted in quarter notes like a host song
+	/// position, while the beats of delay_beats, stop_beats, sync_beats
+	/// and sync_offset are beats of the time signature (an eighth in
+	/// 6/8). The frames per quarter note are computed once per tempo
+	/// change, so converting between beats and frames inside a block
+	/// is a multiplication.
+	class Transport
+	{
+	public:
+		Transport();
+		virtual ~Transport();
+
+		/// Set the tempo in quarter notes per minute
+		void SetTempo(double bpm);
+
+		/// Set the position in quarter notes
+		void SetPosition(double position) { _position = position; }
+
+		/// Set the time signature and the position (in quarter notes)
+		/// of the start of a bar, which the beat grid is aligned to
+		void SetTimeSignature(int numerator, int denominator, double bar = 0);
+
+		/// Set the output sample rate
+		void SetSampleRate(float rate);
+
+		double Tempo() const { return _tempo; }
+		double Position() const { return _position; }
+		int Numerator() const { return _numerator; }
+		int Denominator() const { return _denominator; }
+		double Bar() const { return _bar; }
+
+		/// Length of a time signature beat in quarter notes
+		double BeatLength() const { return 4.0 / _denominator; }
+
+		/// Frames per quarter note at the current tempo
+		double FramesPerQuarter() const { return _frames_per_quarter; }
+
+		/// Move the position forward by frames at the current tempo
+		void Advance(long frames) { _position += frames / _frames_per_quarter; }
+
+		/// Frames from the current position until position, rounded
+		/// up to the first frame at or past it, 0 if already there
+		long FramesUntil(double position) const;
+
+		/// Position beats of the time signature after position
+		double After(double position, double beats) const { return position + beats * BeatLength(); }
+
+		/// First position of the grid every beats beats, shifted by
+		/// offset beats, that is not before position
+		double NextGrid(double position, double beats, double offset) const;
+
+	private:
+		void update();
+
+		double _tempo;
+		double _position;
+		int _numerator;
+		int _denominator;
+		double _bar;
+		float _sample_rate;
+		double _frames_per_quarter;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_TRANSPORT_H
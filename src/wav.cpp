@@ -0,0 +1,250 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include <cstring>
+
+#include "wav.h"
+#include "wav_kernels.h"
+
+namespace sfz
+{
+
+	// little endian integers of the RIFF headers
+	static unsigned long
+	le32(const unsigned char* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long) p[3] << 24);
+	}
+
+	static unsigned
+	le16(const unsigned char* p)
+	{
+		return p[0] | (p[1] << 8);
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class WavFile
+
+	WavFile::WavFile() :
+		_file(0),
+		_channels(0),
+		_bits(0),
+		_float(false),
+		_frames(0),
+		_rate(44100),
+		_data(0),
+		_frame_size(0),
+		_loop_start(-1),
+		_loop_end(-1)
+	{
+#if defined(LIBSFZ_HAVE_AVX2)
+		if (simd::HasAVX2())
+			_convert = kernels::avx2_pcm();
+		else
+#endif
+			_convert = &kernels::convert_pcm<simd::native_t>;
+	}
+
+	WavFile::~WavFile()
+	{
+		Close();
+	}
+
+	bool
+	WavFile::Open(const std::string& path)
+	{
+		Close();
+		_file = std::fopen(path.c_str(), "rb");
+		if (!_file)
+			return false;
+		if (!parse())
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void
+	WavFile::Close()
+	{
+		if (_file)
+			std::fclose(_file);
+		_file = 0;
+	}
+
+	bool
+	WavFile::parse()
+	{
+		unsigned char header[12];
+		if (std::fread(header, 1, 12, _file) != 12 ||
+		    std::memcmp(header, "RIFF", 4) || std::memcmp(header + 8, "WAVE", 4))
+			return false;
+
+		bool format = false;
+		bool data = false;
+		_loop_start = _loop_end = -1;
+		unsigned char chunk[8];
+		long position = 12;
+		while (std::fread(chunk, 1, 8, _file) == 8)
+		{
+			unsigned long size = le32(chunk + 4);
+			position += 8;
+
+			if (!std::memcmp(chunk, "fmt ", 4) && size >= 16)
+			{
+				unsigned char fmt[40];
+				unsigned long n = (size < sizeof(fmt)) ? size : sizeof(fmt);
+				if (std::fread(fmt, 1, n, _file) != n)
+					return false;
+
+				// WAVE_FORMAT_EXTENSIBLE keeps the real tag in the sub format
+				unsigned tag = le16(fmt);
+				if (tag == 0xfffe && n >= 26)
+					tag = le16(fmt + 24);
+				_channels = le16(fmt + 2);
+				_rate = float(le32(fmt + 4));
+				_bits = le16(fmt + 14);
+				_float = (tag == 3);
+				if ((tag != 1 && tag != 3) || _channels < 1 ||
+				    (_float ? _bits != 32 : (_bits != 8 && _bits != 16 && _bits != 24 && _bits != 32)))
+					return false;
+				_frame_size = _channels * _bits / 8;
+				format = true;
+			}
+			else if (!std::memcmp(chunk, "data", 4) && format)
+			{
+				_data = position;
+				_frames = size / _frame_size;
+				data = true;
+			}
+			else if (!std::memcmp(chunk, "smpl", 4) && size >= 60)
+			{
+				// the first sample loop follows the 36 byte header
+				unsigned char smpl[60];
+				if (std::fread(smpl, 1, 60, _file) != 60)
+					return false;
+				if (le32(smpl + 28) > 0)
+				{
+					_loop_start = le32(smpl + 44);
+					_loop_end = le32(smpl + 48);
+				}
+			}
+
+			// chunks are padded to an even size, a truncated last
+			// chunk just ends the file
+			position += size + (size & 1);
+			if (std::fseek(_file, position, SEEK_SET))
+				break;
+		}
+
+		if (data && _loop_end >= _frames)
+			_loop_end = _frames - 1;
+		if (_loop_end <= _loop_start)
+			_loop_start = _loop_end = -1;
+		return data;
+	}
+
+	long
+	WavFile::Read(long start, long frames, float* const* out)
+	{
+		return read(start, frames, out, 0, 0);
+	}
+
+	long
+	WavFile::Read(long start, long frames, unsigned char* const* out, int width)
+	{
+		if (_float)
+			return 0;
+		return read(start, frames, 0, out, width);
+	}
+
+	long
+	WavFile::Read(Sample* sample)
+	{
+		sample->loop_start = _loop_start;
+		sample->loop_end = _loop_end;
+		int last = sample->Channels() - 1;
+		if (sample->Format() == SAMPLE_FLOAT)
+		{
+			float* out[2] = { sample->Data(0), sample->Data(last) };
+			return Read(0, sample->Preloaded(), out);
+		}
+		unsigned char* out[2] = { sample->Packed(0), sample->Packed(last) };
+		return Read(0, sample->Preloaded(), out, sample->Width());
+	}
+
+	long
+	WavFile::read(long start, long frames, float* const* out, unsigned char* const* packed, int width)
+	{
+		if (!_file || start < 0 || start >= _frames)
+			return 0;
+		if (frames > _frames - start)
+			frames = _frames - start;
+		if (std::fseek(_file, _data + start * _frame_size, SEEK_SET))
+			return 0;
+
+		// large reads keep the disk streaming, the 4 bytes in front let
+		// the kernels read the word ending with the first sample
+		const long chunk = (256 * 1024) / _frame_size;
+		_buffer.resize(4 + chunk * _frame_size);
+		int channels = (_channels > 1) ? 2 : 1;
+		int bytes = _bits / 8;
+
+		long done = 0;
+		while (done < frames)
+		{
+			long n = (frames - done < chunk) ? frames - done : chunk;
+			n = std::fread(&_buffer[4], _frame_size, n, _file);
+			if (n <= 0)
+				break;
+
+			for (int c = 0; c < channels; ++c)
+			{
+				const unsigned char* words = &_buffer[c * bytes + bytes];
+				if (out)
+					_convert(words, _frame_size, _bits, _float, out[c] + done, n);
+				else
+					repack(words, n, packed[c] + done * width, width);
+			}
+			done += n;
+		}
+
+		return done;
+	}
+
+	void
+	WavFile::repack(const unsigned char* words, long frames, unsigned char* out, int width) const
+	{
+		// the top width bytes of each word, signed like the 16 and 24
+		// bit PCM they are decoded as
+		const unsigned long mask = (_bits < 32) ? (0xffffffffUL << (32 - _bits)) & 0xffffffffUL : 0xffffffffUL;
+		const unsigned long flip = (_bits == 8) ? 0x80000000UL : 0;
+		for (long i = 0; i < frames; ++i, words += _frame_size, out += width)
+		{
+			unsigned long word = ((le32(words) & mask) ^ flip) >> (32 - width * 8);
+			for (int b = 0; b < width; ++b)
+				out[b] = (unsigned char) (word >> (b * 8));
+		}
+	}
+
+} // !namespace sfz
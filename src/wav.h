@@ -0,0 +1,107 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_WAV_H
+#define LIBSFZ_WAV_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "sample.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class WavFile
+
+	/// Reader of RIFF WAVE files with 8, 16, 24 or 32 bit integer
+	/// or 32 bit float PCM
+	///
+	/// Frames are read from anywhere in the file and converted to one
+	/// float array per channel by a vectorized kernel, only the first
+	/// two channels are read. The first loop of a smpl chunk gives the
+	/// loop points. A WavFile must only be used by one thread at a time.
+	class WavFile
+	{
+	public:
+		/// Convert frames of one channel, see wav_kernels.h
+		typedef void (*convert_fn)(const unsigned char* words, int stride, int bits, bool real,
+					   float* out, long frames);
+
+		WavFile();
+		virtual ~WavFile();
+
+		/// Open path and parse its header, false if it is not a supported WAV file
+		bool Open(const std::string& path);
+		void Close();
+		bool IsOpen() const { return _file != 0; }
+
+		/// Read frames starting at frame start into out[channel], returns the frames read
+		long Read(long start, long frames, float* const* out);
+
+		/// Read frames as little endian integers of width bytes, the
+		/// file samples in the top bits, only for integer PCM
+		long Read(long start, long frames, unsigned char* const* out, int width);
+
+		/// Read the frames held by sample in its format, from the first
+		/// on, and the loop points; returns the frames read
+		long Read(Sample* sample);
+
+		int Channels() const { return _channels; }
+		long Frames() const { return _frames; }
+		float Rate() const { return _rate; }
+
+		/// Bits per sample, 32 for float PCM
+		int Bits() const { return _bits; }
+		bool IsFloat() const { return _float; }
+
+		/// Loop points of the smpl chunk (end inclusive), -1 if there are none
+		long LoopStart() const { return _loop_start; }
+		long LoopEnd() const { return _loop_end; }
+
+		/// Size of a frame in the file, in bytes
+		int FrameSize() const { return _frame_size; }
+	private:
+		WavFile(const WavFile&);
+		WavFile& operator=(const WavFile&);
+
+		bool parse();
+		long read(long start, long frames, float* const* out, unsigned char* const* packed, int width);
+		void repack(const unsigned char* words, long frames, unsigned char* out, int width) const;
+
+		std::FILE* _file;
+		int _channels;
+		int _bits;
+		bool _float;
+		long _frames;
+		float _rate;
+		long _data;
+		int _frame_size;
+		long _loop_start;
+		long _loop_end;
+		convert_fn _convert;
+		std::vector<unsigned char> _buffer;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_WAV_H
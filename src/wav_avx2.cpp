@@ -0,0 +1,39 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+// Built with AVX2 and FMA enabled, only called after a runtime check.
+
+#include "wav_kernels.h"
+
+namespace sfz
+{
+namespace kernels
+{
+
+	WavFile::convert_fn
+	avx2_pcm()
+	{
+		return &convert_pcm<simd::avx2_t>;
+	}
+
+} // !namespace kernels
+} // !namespace sfz
@@ -0,0 +1,80 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_WAV_KERNELS_H
+#define LIBSFZ_WAV_KERNELS_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// PCM conversion kernels shared by the per instruction set translation
+// units. Not part of the public interface.
+
+#include "wav.h"
+#include "simd.h"
+
+namespace sfz
+{
+namespace kernels
+{
+
+#if defined(LIBSFZ_HAVE_AVX2)
+	/// PCM kernel compiled for AVX2, defined in wav_avx2.cpp
+	WavFile::convert_fn avx2_pcm();
+#endif
+
+	// one copy per translation unit, see simd.h
+	namespace
+	{
+
+	// Every sample is read as the little endian 32 bit word ending with
+	// its last byte, which leaves it in the top bits whatever its size:
+	// masking the bytes below it and converting the word gives the
+	// sample scaled by 2^31. 8 bit samples are unsigned and get their
+	// sign bit flipped. words points at the word of the first frame,
+	// stride is the size of a frame in bytes.
+	template<class S>
+	void
+	convert_pcm(const unsigned char* words, int stride, int bits, bool real, float* out, long frames)
+	{
+		typedef typename S::V V;
+		typedef typename S::I I;
+		const I mask = S::set1i((bits < 32) ? int(~0u << (32 - bits)) : -1);
+		const I flip = S::set1i((bits == 8) ? int(0x80000000u) : 0);
+		const V scale = S::set1(1.0f / 2147483648.0f);
+
+		// frames of 4 bytes are contiguous words, others are gathered
+		long i = 0;
+		for (; i + S::width <= frames; i += S::width, words += S::width * stride)
+		{
+			I w = (stride == 4) ? S::loadi(words) : S::gatheri(words, stride);
+			if (real)
+				S::storeu(out + i, S::as_float(w));
+			else
+				S::storeu(out + i, S::mul(S::to_float(S::xori(S::andi(w, mask), flip)), scale));
+		}
+
+		if (S::width > 1 && i < frames)
+			convert_pcm<simd::scalar_t>(words, stride, bits, real, out + i, frames - i);
+	}
+
+	} // !namespace
+
+} // !namespace kernels
+} // !namespace sfz
+
+#endif // !LIBSFZ_WAV_KERNELS_H
@@ -0,0 +1,162 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "xfade.h"
+
+#include <cmath>
+
+namespace sfz
+{
+
+	static int
+	clamp_value(int value)
+	{
+		if (value < 0) return 0;
+		if (value > 127) return 127;
+		return value;
+	}
+
+	static float
+	fade_in(int value, int lo, int hi)
+	{
+		if (value >= hi) return 1.0f;
+		if (value <= lo) return 0.0f;
+		return float(value - lo) / float(hi - lo);
+	}
+
+	static float
+	fade_out(int value, int lo, int hi)
+	{
+		if (value <= lo) return 1.0f;
+		if (value >= hi) return 0.0f;
+		return float(hi - value) / float(hi - lo);
+	}
+
+	static float
+	apply_curve(float x, curve_t curve)
+	{
+		// gain is linear in the controller, power keeps the sum of
+		// the squared gains of two complementary layers constant
+		return (curve == POWER) ? std::sqrt(x) : x;
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class CrossfadeTables
+
+	CrossfadeTables::CrossfadeTables()
+	{
+	}
+
+	CrossfadeTables::~CrossfadeTables()
+	{
+	}
+
+	const float*
+	CrossfadeTables::Get(int in_lo, int in_hi, int out_lo, int out_hi, curve_t curve)
+	{
+		in_lo = clamp_value(in_lo); in_hi = clamp_value(in_hi);
+		out_lo = clamp_value(out_lo); out_hi = clamp_value(out_hi);
+
+		// all ranges that leave the gain untouched map to one table
+		if (in_hi == 0) in_lo = 0;
+		if (out_lo == 127) out_hi = 127;
+		if (in_hi == 0 && out_lo == 127) curve = GAIN;
+
+		unsigned long key =
+			(unsigned long) in_lo         |
+			(unsigned long) in_hi  <<  7  |
+			(unsigned long) out_lo << 14  |
+			(unsigned long) out_hi << 21  |
+			(unsigned long) curve  << 28;
+
+		std::map<unsigned long, const float*>::iterator it = _index.find(key);
+		if (it != _index.end())
+			return it->second;
+
+		_tables.push_back(table_t());
+		table_t& table = _tables.back();
+		for (int i = 0; i < 128; ++i)
+			table[i] = apply_curve(fade_in(i, in_lo, in_hi), curve) *
+				apply_curve(fade_out(i, out_lo, out_hi), curve);
+
+		_index[key] = table.data();
+		return table.data();
+	}
+
+	const float*
+	CrossfadeTables::Unity()
+	{
+		return Get(0, 0, 127, 127, GAIN);
+	}
+
+	int
+	CrossfadeTables::Size() const
+	{
+		return _tables.size();
+	}
+
+	/////////////////////////////////////////////////////////////
+	// class Crossfade
+
+	Crossfade::Crossfade() :
+		key_gain(0),
+		vel_gain(0)
+	{
+	}
+
+	Crossfade::Crossfade(const Region* region, CrossfadeTables& tables)
+	{
+		Compile(region, tables);
+	}
+
+	Crossfade::~Crossfade()
+	{
+	}
+
+	void
+	Crossfade::Compile(const Region* region, CrossfadeTables& tables)
+	{
+		key_gain = tables.Get(region->xfin_lokey, region->xfin_hikey,
+				      region->xfout_lokey, region->xfout_hikey,
+				      region->xf_keycurve);
+		vel_gain = tables.Get(region->xfin_lovel, region->xfin_hivel,
+				      region->xfout_lovel, region->xfout_hivel,
+				      region->xf_velcurve);
+
+		// only controllers with a non-trivial range end up in the list
+		const float* unity = tables.Unity();
+		controls.clear();
+		for (int i = 0; i < 128; ++i)
+		{
+			const float* gain = tables.Get(region->xfin_locc[i], region->xfin_hicc[i],
+						       region->xfout_locc[i], region->xfout_hicc[i],
+						       region->xf_cccurve);
+			if (gain == unity)
+				continue;
+
+			control_t control;
+			control.cc = i;
+			control.gain = gain;
+			controls.push_back(control);
+		}
+	}
+
+} // !namespace sfz
@@ -0,0 +1,121 @@
+/* -*- Mode: C++ ; c-basic-offset: 8 -*- */
+#ifndef LIBSFZ_XFADE_H
+#define LIBSFZ_XFADE_H
+
+// SFZ 1.0
+// Copyright (c) 2008-2009, Anders Dahnielson
+//
+// Contact: anders@dahnielson.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <boost/array.hpp>
+
+#include "sfz.h"
+
+namespace sfz
+{
+
+	/////////////////////////////////////////////////////////////
+	// class CrossfadeTables
+
+	/// Owns the baked 128-entry crossfade gain tables
+	///
+	/// Tables are keyed by their fade-in/fade-out range and curve,
+	/// so every region using the same crossfade shares one table.
+	class CrossfadeTables
+	{
+	public:
+		CrossfadeTables();
+		virtual ~CrossfadeTables();
+
+		/// Return the gain table for the given ranges and curve
+		const float* Get(int in_lo, int in_hi, int out_lo, int out_hi, curve_t curve);
+
+		/// Return the table that is 1.0 for every value
+		const float* Unity();
+
+		/// Number of distinct tables baked so far
+		int Size() const;
+
+	private:
+		typedef boost::array<float, 128> table_t;
+
+		std::list<table_t> _tables;
+		std::map<unsigned long, const float*> _index;
+	};
+
+	/////////////////////////////////////////////////////////////
+	// class Crossfade
+
+	/// Compiled key, velocity and CC crossfades of a Region
+	///
+	/// Key and velocity gain are fixed at note-on; the CC gain has to
+	/// be re-evaluated whenever one of the listed controllers changes.
+	class Crossfade
+	{
+	public:
+		Crossfade();
+		Crossfade(const Region* region, CrossfadeTables& tables);
+		virtual ~Crossfade();
+
+		/// Bake the crossfades of region
+		void Compile(const Region* region, CrossfadeTables& tables);
+
+		/// Return the key and velocity crossfade gain for a note
+		float GetNoteGain(uint8_t key, uint8_t vel) const
+		{
+			return key_gain[key] * vel_gain[vel];
+		}
+
+		/// Return the product of all CC crossfade gains
+		float GetControlGain(const uint8_t* cc) const
+		{
+			float gain = 1.0f;
+			for (std::vector<control_t>::const_iterator it = controls.begin(); it != controls.end(); ++it)
+				gain *= it->gain[cc[it->cc]];
+			return gain;
+		}
+
+		/// Return true if the region has any CC crossfade
+		bool HasControl() const { return !controls.empty(); }
+
+		/// Return true if cont is one of the crossfade controllers
+		bool IsControl(uint8_t cont) const
+		{
+			for (std::vector<control_t>::const_iterator it = controls.begin(); it != controls.end(); ++it)
+				if (it->cc == cont) return true;
+			return false;
+		}
+
+		/// (cc, table) pair of a CC crossfade
+		struct control_t
+		{
+			uint8_t cc;
+			const float* gain;
+		};
+
+		const float* key_gain;
+		const float* vel_gain;
+		std::vector<control_t> controls;
+	};
+
+} // !namespace sfz
+
+#endif // !LIBSFZ_XFADE_H